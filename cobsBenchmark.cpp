@@ -0,0 +1,1337 @@
+/*
+ * Benchmark suite for COBSParser.
+ *
+ * Sweeps payload sizes from 1 byte to well past MAX_FRAME_SIZE and a range of ASCII_NULL densities, timing encode, decode and the checksum
+ * on their own with memcpy of the same payload as the reference ceiling. The byte at a time decoder COBSParser::decodeMessage used before
+ * block copies is kept here as a baseline for the decoder.
+ *
+ * Every call in a measurement works on a different payload of the same size and density, with its own encoded frame, from a pool covering
+ * BYTES_PER_RUN. Replaying one payload lets the branch predictor learn exactly where its ASCII_NULL bytes are, which makes the dense payloads
+ * look far faster than real traffic.
+ *
+ * Build:   make, or g++ -std=c++17 -O2 cobsBenchmark.cpp cobsParser.cpp cobsKernels.cpp cobsChecksum.cpp cobsDispatch.cpp -o cobsBenchmark
+ * Run:     ./cobsBenchmark [xor|crc8|crc16|crc32|crc32c]
+ *          ./cobsBenchmark --alloc-check
+ *          ./cobsBenchmark --self-test
+ *          COBS_KERNEL=scalar ./cobsBenchmark, to compare the kernel levels (see cobsDispatch.hpp).
+ *
+ * On Linux the hardware performance counters (cycles, instructions, branch misses and L1D read misses) are read with perf_event_open around
+ * every measurement, giving core cycles/byte, IPC, branch misses/byte and L1D misses/byte. If they cannot be opened, e.g. because of
+ * kernel.perf_event_paranoid or inside a VM, cycles/byte falls back to the time stamp counter (which ticks at a constant rate rather than
+ * the core clock, and reads 0 where there is none) and the other columns read "-". As no payload is repeated within a measurement, branch
+ * misses/byte shows the cost of the ASCII_NULL pattern to a predictor which has not seen it before. For a given density it should stay level
+ * as the payload size grows, so comparing it across COBS_KERNEL levels shows whether a kernel wins by taking fewer mispredicted branches.
+ *
+ * The global operator new and delete are replaced with counting versions, so every measurement also reports heap allocations per frame.
+ * --alloc-check runs each API which should be allocation free once warmed up and fails (exit code 1) if any of them allocates,
+ * as a regression guard for the allocation free paths.
+ *
+ * --self-test checks every checksum against its catalogued "123456789" check value and the hardware CRC kernels against the tables,
+ * so a mistake in the folding constants or stream combine tables is caught. It also checks encodeInPlace(), encodeGather() and
+ * encodeToSegments() give exactly the frame encodeMessage() does and that decodeInPlace() gives back the payload, and that decodeBatch() and the stream decoder resynchronise after oversized
+ * frames, including when a frame is split across calls. The stream decoder is fed back to back frames, with corrupted, empty and cut short
+ * frames among them, in random sized chunks and must pass exactly the good messages to its callback. The frame table decodeBatch() builds
+ * for a batch like it is checked entry by entry against the arena, along with the start of the trailing partial frame it returns.
+ * Run it under each COBS_KERNEL level to cover every kernel.
+ */
+
+// Standard Libraries.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Application Libraries.
+#include "cobsDispatch.hpp"
+#include "cobsParser.hpp"
+
+
+namespace
+{
+    constexpr uint32_t BYTES_PER_RUN = (16U * 1024U * 1024U); // Amount of data each measurement processes, large enough to hide timer resolution.
+    constexpr uint32_t MIN_ITERATIONS = 16U; // Large payloads are still measured over several calls.
+    constexpr uint32_t MAX_ITERATIONS = (1U << 20U); // Stops tiny payloads from taking minutes.
+    constexpr uint32_t MAX_PAYLOAD_SIZE = (64U * 1024U); // Largest payload measured.
+    constexpr uint32_t ALLOCATION_WARM_UP = 16U; // Calls made before allocations are counted, letting buffers reach their steady state capacity.
+    constexpr uint32_t ALLOCATION_ITERATIONS = 4096U; // Calls checked for allocations, more than VectorStorage::SHRINK_INTERVAL so a shrink check is included.
+    constexpr uint32_t SELF_TEST_MAX_CRC_SIZE = 3000U; // Hardware CRC kernels are checked against the tables for every size up to this, well past several folds and stream combines.
+    constexpr uint32_t SELF_TEST_FRAME_COUNT = 64U; // Frames in the streams and batches decoded by the self test.
+    constexpr uint32_t SELF_TEST_CHUNK_ROUNDS = 12U; // Times the stream is fed to the stream decoder, with chunks of up to 2^round bytes.
+
+    // The payload sizes go past COBSParser::MAX_FRAME_SIZE, so frames are handled by a codec with the same format and a higher limit.
+    template <typename ChecksumPolicy>
+    using BenchmarkCodec = BasicCOBSCodec<MAX_PAYLOAD_SIZE, COBSParser::DELIMITER, ChecksumPolicy>;
+
+    const uint32_t PAYLOAD_SIZES[] = {1U, 16U, 64U, 256U, COBSParser::MAX_FRAME_SIZE, 4096U, MAX_PAYLOAD_SIZE};
+
+    // How often ASCII_NULL appears in a payload.
+    struct ZeroDensity
+    {
+        const char* name; // Name printed in the results.
+        uint32_t zeroPercent; // Chance of each byte being ASCII_NULL.
+        bool runsOf254; // Ignore zeroPercent, instead every run of 254 bytes is followed by ASCII_NULL so every block is exactly full.
+    };
+
+    const ZeroDensity ZERO_DENSITIES[] = {{"0%", 0U, false}, {"1%", 1U, false}, {"10%", 10U, false}, {"50%", 50U, false}, {"100%", 100U, false}, {"254 runs", 0U, true}};
+
+    // Distinct payloads of one size and density with their encoded frames, see makePayloadPool(). Each call of a measurement uses the next one.
+    struct PayloadPool
+    {
+        uint32_t payloadSize; // Total number of bytes in each payload.
+        uint32_t frameStride; // Bytes reserved for each encoded frame, maxEncodedSize() of the payload size.
+        std::vector<uint8_t> payloads; // Every payload, back to back.
+        std::vector<uint8_t> frames; // Encoded frame of each payload, frameStride bytes apart.
+        std::vector<uint32_t> frameSizes; // Total number of bytes in each encoded frame.
+    };
+
+    // Hardware performance counters read around each measurement.
+    enum Counter : uint32_t
+    {
+        CYCLES,
+        INSTRUCTIONS,
+        BRANCH_MISSES,
+        L1D_MISSES,
+        COUNTER_COUNT
+    };
+
+    // Cost of a single call to the operation under test.
+    struct Measurement
+    {
+        double nanoseconds; // Average wall clock time per call.
+        double cycles; // Average time stamp counter ticks per call.
+        double counters[COUNTER_COUNT]; // Average hardware counter values per call, NaN for counters which could not be opened.
+        double allocations; // Average heap allocations per call.
+    };
+
+    uint64_t allocationCount = 0U; // Calls to the global operator new, see the replacements below.
+
+
+    /*
+     * Group of perf_event_open hardware counters for this thread, counting user space only.
+     * Counters the CPU or kernel does not support are left out, the whole group is unavailable if even the cycle counter cannot be opened.
+     */
+    class PerfCounters
+    {
+        public:
+            PerfCounters();
+            ~PerfCounters();
+
+            bool isAvailable(void) const { return (m_leader >= 0); }
+            void start(void);
+            void stop(double (&counts)[COUNTER_COUNT]);
+
+        private:
+            int m_leader = -1; // Cycle counter, which the others are grouped under so they are all scheduled together.
+            int m_descriptors[COUNTER_COUNT]; // File descriptor of each counter, -1 if it could not be opened.
+            uint32_t m_slots[COUNTER_COUNT]; // Position of each counter in the group read.
+            uint32_t m_counterCount = 0U; // Total number of counters opened.
+    };
+
+    volatile uint32_t sink = 0U; // Results are written here so the compiler cannot discard the work being timed.
+
+
+    /*
+     * The byte at a time decoder COBSParser::decodeMessage used before block copies, kept as the baseline to compare against.
+     *
+     * @param   input: Data to decode.
+     * @param   inputSize: Total number of bytes in data.
+     * @param   message: Location to store the decoded message.
+     *
+     * @return  True if decoded message is validated, else false.
+     */
+    bool
+    decodeByteAtATime(const uint8_t* input, const uint32_t inputSize, std::vector<uint8_t>& message)
+    {
+        std::vector<uint8_t> output;
+        output.reserve(inputSize);
+
+        const uint8_t *encodedMessage = input;
+        uint8_t overheadCount = 0xFFU;
+        const uint8_t *encodedMessageEnd = (input + inputSize);
+
+        for (uint8_t blockSize = 0; encodedMessage < encodedMessageEnd; --blockSize)
+        {
+            if (blockSize > 0U)
+            {
+                output.push_back(*encodedMessage++);
+            }
+            else
+            {
+                blockSize = *encodedMessage++;
+
+                if (blockSize == COBSParser::ASCII_NULL)
+                {
+                    break;
+                }
+
+                if (overheadCount != 0xFFU)
+                {
+                    output.push_back(COBSParser::ASCII_NULL);
+                }
+
+                overheadCount = blockSize;
+            }
+        }
+
+        if (output.empty())
+        {
+            return false;
+        }
+
+        const uint8_t receivedCRC = output.back();
+        output.pop_back();
+
+        uint8_t calculatedCRC = 0U;
+
+        for (const uint8_t byte : output)
+        {
+            calculatedCRC ^= byte;
+        }
+
+        if (calculatedCRC != receivedCRC)
+        {
+            return false;
+        }
+
+        message = std::move(output);
+
+        return true;
+    }
+
+
+    /*
+     * Fills a payload with the given density of ASCII_NULL bytes, or of another delimiter.
+     *
+     * @param   payload: Location to store the payload.
+     * @param   size: Total number of bytes in the payload.
+     * @param   density: How often ASCII_NULL appears.
+     * @param   generator: Source of the random bytes, carried on from one payload to the next so each is different.
+     * @param   delimiter: Byte placed where ASCII_NULL would be, for codecs with a different delimiter.
+     */
+    void
+    fillPayload(uint8_t* payload, const uint32_t size, const ZeroDensity& density, std::mt19937& generator, const uint8_t delimiter)
+    {
+        std::uniform_int_distribution<uint32_t> byteDistribution(1U, 0xFFU);
+        std::uniform_int_distribution<uint32_t> percentDistribution(0U, 99U);
+
+        for (uint32_t i = 0U; i < size; ++i)
+        {
+            const bool isNull = (density.runsOf254 ? ((i % 255U) == 254U) : (percentDistribution(generator) < density.zeroPercent));
+
+            const uint8_t byte = static_cast<uint8_t>(byteDistribution(generator));
+
+            // Any other byte stands in for a random byte equal to the delimiter, so the density holds for every delimiter.
+            payload[i] = (isNull ? delimiter : ((byte == delimiter) ? COBSParser::ASCII_NULL : byte));
+        }
+    }
+
+
+    /*
+     * Generates a payload with the given density of ASCII_NULL bytes, or of another delimiter.
+     *
+     * @param   size: Total number of bytes in the payload.
+     * @param   density: How often ASCII_NULL appears.
+     * @param   delimiter: Byte placed where ASCII_NULL would be, for codecs with a different delimiter.
+     *
+     * @return  The payload.
+     */
+    std::vector<uint8_t>
+    makePayload(const uint32_t size, const ZeroDensity& density, const uint8_t delimiter = COBSParser::ASCII_NULL)
+    {
+        std::mt19937 generator(size); // Fixed seed so every run measures the same data.
+        std::vector<uint8_t> payload(size);
+
+        fillPayload(payload.data(), size, density, generator, delimiter);
+
+        return payload;
+    }
+
+
+    /*
+     * Generates a pool of distinct payloads of one size and density, and encodes each of them.
+     *
+     * @tparam  Codec: Codec the frames are encoded with.
+     * @param   pool: Location to store the payloads and frames.
+     * @param   payloadSize: Total number of bytes in each payload.
+     * @param   density: How often ASCII_NULL appears.
+     * @param   count: Total number of payloads.
+     */
+    template <typename Codec>
+    void
+    makePayloadPool(PayloadPool& pool, const uint32_t payloadSize, const ZeroDensity& density, const uint32_t count)
+    {
+        std::mt19937 generator(payloadSize); // Fixed seed so every run measures the same data.
+
+        pool.payloadSize = payloadSize;
+        pool.frameStride = Codec::maxEncodedSize(payloadSize);
+        pool.payloads.resize(static_cast<size_t>(count) * payloadSize);
+        pool.frames.resize(static_cast<size_t>(count) * pool.frameStride);
+        pool.frameSizes.resize(count);
+
+        for (uint32_t i = 0U; i < count; ++i)
+        {
+            uint8_t *payload = (pool.payloads.data() + (static_cast<size_t>(i) * payloadSize));
+
+            fillPayload(payload, payloadSize, density, generator, Codec::DELIMITER);
+            pool.frameSizes[i] = Codec::encodeMessage(payload, payloadSize, (pool.frames.data() + (static_cast<size_t>(i) * pool.frameStride)), pool.frameStride);
+        }
+    }
+
+
+    /*
+     * Reads the time stamp counter.
+     *
+     * @return  Current tick count, zero where there is no counter.
+     */
+    inline uint64_t
+    readCycleCounter(void)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0U;
+#endif
+    }
+
+
+    /*
+     * Opens the counters, see isAvailable() for whether it worked.
+     */
+    PerfCounters::PerfCounters()
+    {
+        for (int& descriptor : m_descriptors)
+        {
+            descriptor = -1;
+        }
+
+#ifdef __linux__
+        const uint64_t configs[COUNTER_COUNT][2] =
+        {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HW_CACHE, (PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8U) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U))}
+        };
+
+        for (uint32_t counter = 0U; counter < COUNTER_COUNT; ++counter)
+        {
+            perf_event_attr attributes;
+            std::memset(&attributes, 0, sizeof(attributes));
+            attributes.size = sizeof(attributes);
+            attributes.type = static_cast<uint32_t>(configs[counter][0]);
+            attributes.config = configs[counter][1];
+            attributes.disabled = ((counter == CYCLES) ? 1U : 0U); // Members follow the leader, which is enabled in start().
+            attributes.exclude_kernel = 1U;
+            attributes.exclude_hv = 1U;
+            attributes.read_format = PERF_FORMAT_GROUP;
+
+            const int descriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, m_leader, 0UL));
+
+            if (descriptor < 0)
+            {
+                if (counter == CYCLES)
+                {
+                    return;
+                }
+
+                continue;
+            }
+
+            if (counter == CYCLES)
+            {
+                m_leader = descriptor;
+            }
+
+            m_descriptors[counter] = descriptor;
+            m_slots[counter] = m_counterCount++;
+        }
+#endif
+    }
+
+
+    PerfCounters::~PerfCounters()
+    {
+#ifdef __linux__
+        for (const int descriptor : m_descriptors)
+        {
+            if (descriptor >= 0)
+            {
+                close(descriptor);
+            }
+        }
+#endif
+    }
+
+
+    /*
+     * Zeroes and starts every counter.
+     */
+    void
+    PerfCounters::start(void)
+    {
+#ifdef __linux__
+        if (isAvailable())
+        {
+            ioctl(m_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+
+    /*
+     * Stops every counter and reads them.
+     *
+     * @param   counts: Location to store the count of each counter, NaN for counters which are not available.
+     */
+    void
+    PerfCounters::stop(double (&counts)[COUNTER_COUNT])
+    {
+        for (double& count : counts)
+        {
+            count = NAN;
+        }
+
+#ifdef __linux__
+        if (!isAvailable())
+        {
+            return;
+        }
+
+        ioctl(m_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        uint64_t values[COUNTER_COUNT + 1U] = {}; // The number of counters, then each of their values.
+
+        if (read(m_leader, values, sizeof(values)) <= 0)
+        {
+            return;
+        }
+
+        for (uint32_t counter = 0U; counter < COUNTER_COUNT; ++counter)
+        {
+            if (m_descriptors[counter] >= 0)
+            {
+                counts[counter] = static_cast<double>(values[m_slots[counter] + 1U]);
+            }
+        }
+#endif
+    }
+
+
+    /*
+     * Runs the function repeatedly and reports the average cost per call.
+     *
+     * @param   counters: Hardware counters to read around the calls.
+     * @param   iterations: Total number of calls to time.
+     * @param   function: Function under test, called as function(index) with index counting up from zero, to select the payload from the pool.
+     *
+     * @return  Average cost per call.
+     */
+    template <typename Function>
+    Measurement
+    measure(PerfCounters& counters, const uint32_t iterations, Function&& function)
+    {
+        Measurement measurement;
+
+        function(0U); // Warm up caches and let any buffers reach their steady state capacity.
+
+        const uint64_t startAllocations = allocationCount;
+        counters.start();
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t startCycles = readCycleCounter();
+
+        for (uint32_t i = 0U; i < iterations; ++i)
+        {
+            function(i);
+        }
+
+        const uint64_t endCycles = readCycleCounter();
+        const auto end = std::chrono::steady_clock::now();
+        counters.stop(measurement.counters);
+        const uint64_t endAllocations = allocationCount;
+
+        measurement.nanoseconds = (std::chrono::duration<double, std::nano>(end - start).count() / iterations);
+        measurement.cycles = (static_cast<double>(endCycles - startCycles) / iterations);
+        measurement.allocations = (static_cast<double>(endAllocations - startAllocations) / iterations);
+
+        for (double& count : measurement.counters)
+        {
+            count /= iterations;
+        }
+
+        return measurement;
+    }
+
+
+    /*
+     * Formats a value for the results table.
+     *
+     * @param   text: Location to store the text.
+     * @param   value: Value to format, NaN is shown as "-".
+     *
+     * @return  text.
+     */
+    const char*
+    formatValue(char (&text)[16], const double value)
+    {
+        if (std::isnan(value))
+        {
+            std::snprintf(text, sizeof(text), "-");
+        }
+        else
+        {
+            std::snprintf(text, sizeof(text), "%.3f", value);
+        }
+
+        return text;
+    }
+
+
+    /*
+     * Prints one row of results. The per byte columns are the per call costs divided by the payload size.
+     *
+     * @param   payloadSize: Total number of bytes in the payload.
+     * @param   density: Name of the ASCII_NULL density.
+     * @param   operation: Name of the operation measured.
+     * @param   measurement: Cost per call.
+     */
+    void
+    report(const uint32_t payloadSize, const char* density, const char* operation, const Measurement& measurement)
+    {
+        const double cycles = (std::isnan(measurement.counters[CYCLES]) ? measurement.cycles : measurement.counters[CYCLES]); // Core cycles when available.
+        char ipc[16];
+        char branchMisses[16];
+        char l1dMisses[16];
+
+        std::printf("%-8u %-9s %-20s %12.1f %10.3f %12.3f %8s %12s %12s %12.2f\n", payloadSize, density, operation, measurement.nanoseconds,
+                    (payloadSize / measurement.nanoseconds), (cycles / payloadSize),
+                    formatValue(ipc, (measurement.counters[INSTRUCTIONS] / measurement.counters[CYCLES])),
+                    formatValue(branchMisses, (measurement.counters[BRANCH_MISSES] / payloadSize)),
+                    formatValue(l1dMisses, (measurement.counters[L1D_MISSES] / payloadSize)), measurement.allocations);
+    }
+
+
+    /*
+     * Runs the whole sweep for one checksum.
+     *
+     * @tparam  ChecksumPolicy: Checksum used as the CRC.
+     * @param   counters: Hardware counters to read around each measurement.
+     * @param   includeByteLoop: Also time the byte at a time decoder, which only understands the XOR checksum.
+     */
+    template <typename ChecksumPolicy>
+    void
+    runSuite(PerfCounters& counters, const bool includeByteLoop)
+    {
+        using Codec = BenchmarkCodec<ChecksumPolicy>;
+
+        PayloadPool pool; // Reused for every row, so it only grows to the largest pool once.
+
+        std::printf("%-8s %-9s %-20s %12s %10s %12s %8s %12s %12s %12s\n", "payload", "zeros", "operation", "ns/frame", "GB/s", "cycles/byte", "IPC",
+                    "br-miss/byte", "L1D-miss/byte", "allocs/frame");
+
+        for (const uint32_t payloadSize : PAYLOAD_SIZES)
+        {
+            for (const ZeroDensity& density : ZERO_DENSITIES)
+            {
+                const uint32_t iterations = std::max(MIN_ITERATIONS, std::min(MAX_ITERATIONS, (BYTES_PER_RUN / payloadSize)));
+                std::vector<uint8_t> decoded(Codec::maxEncodedSize(payloadSize));
+                std::vector<uint8_t> message;
+                uint32_t messageSize = 0U;
+
+                makePayloadPool<Codec>(pool, payloadSize, density, iterations); // One payload per call, so none is seen twice in a measurement.
+
+                const auto payload = [&](const uint32_t index) { return (pool.payloads.data() + (static_cast<size_t>(index) * payloadSize)); };
+                const auto frame = [&](const uint32_t index) { return (pool.frames.data() + (static_cast<size_t>(index) * pool.frameStride)); };
+
+                report(payloadSize, density.name, "memcpy", measure(counters, iterations, [&](const uint32_t index)
+                {
+                    std::memcpy(decoded.data(), payload(index), payloadSize);
+                    sink = sink + decoded[0];
+                }));
+
+                report(payloadSize, density.name, "checksum", measure(counters, iterations, [&](const uint32_t index)
+                {
+                    sink = sink + static_cast<uint32_t>(ChecksumPolicy::update(ChecksumPolicy::begin(), payload(index), payloadSize));
+                }));
+
+                report(payloadSize, density.name, "encode", measure(counters, iterations, [&](const uint32_t index)
+                {
+                    sink = sink + Codec::encodeMessage(payload(index), payloadSize, decoded.data(), static_cast<uint32_t>(decoded.size()));
+                }));
+
+                report(payloadSize, density.name, "decode", measure(counters, iterations, [&](const uint32_t index)
+                {
+                    sink = sink + static_cast<uint32_t>(Codec::decodeMessage(frame(index), pool.frameSizes[index], decoded.data(), static_cast<uint32_t>(decoded.size()), messageSize));
+                }));
+
+                if (includeByteLoop)
+                {
+                    report(payloadSize, density.name, "decode (byte loop)", measure(counters, iterations, [&](const uint32_t index)
+                    {
+                        sink = sink + decodeByteAtATime(frame(index), pool.frameSizes[index], message);
+                    }));
+                }
+            }
+        }
+    }
+
+
+    /*
+     * Checks a function makes no heap allocation once warmed up.
+     *
+     * @param   name: Name printed in the results.
+     * @param   function: Function under test, called once per frame.
+     *
+     * @return  True if no allocation was made.
+     */
+    template <typename Function>
+    bool
+    expectNoAllocations(const char* name, Function&& function)
+    {
+        for (uint32_t i = 0U; i < ALLOCATION_WARM_UP; ++i)
+        {
+            function();
+        }
+
+        const uint64_t startAllocations = allocationCount;
+
+        for (uint32_t i = 0U; i < ALLOCATION_ITERATIONS; ++i)
+        {
+            function();
+        }
+
+        const uint64_t allocations = (allocationCount - startAllocations);
+
+        std::printf("%-36s %8.3f allocs/frame  %s\n", name, (static_cast<double>(allocations) / ALLOCATION_ITERATIONS), ((allocations == 0U) ? "ok" : "FAIL"));
+
+        return (allocations == 0U);
+    }
+
+
+    /*
+     * Runs every API which should be allocation free in steady state and checks none of them allocate.
+     *
+     * @return  True if no steady state allocation was made.
+     */
+    bool
+    checkAllocations(void)
+    {
+        COBSParser parser;
+        COBSStreamDecoder streamDecoder;
+        BasicCOBSCodec<COBSParser::MAX_FRAME_SIZE, COBSParser::DELIMITER, cobs::XORChecksum, cobs::FixedStorage> fixedParser;
+
+        const std::vector<uint8_t> payload = makePayload(COBSParser::MAX_FRAME_SIZE, ZERO_DENSITIES[2]);
+        const uint32_t payloadSize = static_cast<uint32_t>(payload.size());
+        const COBSSegment messages[] = {{payload.data(), (payloadSize / 2U)}, {payload.data(), payloadSize}};
+
+        std::vector<uint8_t> frame;
+        COBSParser::encodeMessage(payload.data(), payloadSize, frame);
+        std::vector<uint8_t> corruptFrame = frame;
+        corruptFrame[corruptFrame.size() / 2U] ^= 0x01U; // Exercises the failed decode path, which must not allocate either.
+
+        std::vector<uint8_t> encoded;
+        std::vector<uint8_t> decoded(frame.size());
+        std::vector<uint8_t> message;
+        std::vector<uint8_t> arena;
+        std::vector<uint8_t> scratch;
+        std::vector<uint8_t> batch;
+        std::vector<uint32_t> offsets;
+        std::vector<COBSIOVec> segments;
+        std::vector<COBSFrame> frames;
+        uint32_t messageSize = 0U;
+        uint32_t frameIndex = 0U;
+        bool passed = true;
+
+        COBSParser::encodeBatch(messages, 2U, batch, offsets);
+
+        passed &= expectNoAllocations("encodeMessage (buffer)", [&]()
+        {
+            sink = sink + COBSParser::encodeMessage(payload.data(), payloadSize, decoded.data(), static_cast<uint32_t>(decoded.size()));
+        });
+
+        passed &= expectNoAllocations("encodeMessage (vector)", [&]() { sink = sink + COBSParser::encodeMessage(payload.data(), payloadSize, encoded); });
+        passed &= expectNoAllocations("encodeToSegments (vector)", [&]() { sink = sink + COBSParser::encodeToSegments(payload.data(), payloadSize, segments, scratch); });
+        passed &= expectNoAllocations("encodeBatch (vector)", [&]() { sink = sink + COBSParser::encodeBatch(messages, 2U, encoded, offsets); });
+        passed &= expectNoAllocations("cobs::encode (vector)", [&]() { sink = sink + cobs::encode(payload.data(), payloadSize, encoded); });
+
+        passed &= expectNoAllocations("decodeMessage (buffer)", [&]()
+        {
+            sink = sink + static_cast<uint32_t>(COBSParser::decodeMessage(frame.data(), static_cast<uint32_t>(frame.size()), decoded.data(), static_cast<uint32_t>(decoded.size()), messageSize));
+        });
+
+        passed &= expectNoAllocations("decodeMessage (VectorStorage)", [&]()
+        {
+            const std::vector<uint8_t>& input = (((frameIndex++ % 4U) == 3U) ? corruptFrame : frame);
+            sink = sink + parser.decodeMessage(input);
+        });
+
+        passed &= expectNoAllocations("decodeMessage (FixedStorage)", [&]() { sink = sink + fixedParser.decodeMessage(frame.data(), static_cast<uint32_t>(frame.size())); });
+
+        passed &= expectNoAllocations("takeMessage/recycleMessage", [&]()
+        {
+            sink = sink + parser.decodeMessage(frame);
+            std::vector<uint8_t> taken = parser.takeMessage();
+            sink = sink + static_cast<uint32_t>(taken.size());
+            parser.recycleMessage(std::move(taken));
+        });
+
+        passed &= expectNoAllocations("decodeInPlace", [&]()
+        {
+            COBSSegment view = {nullptr, 0U};
+            std::memcpy(decoded.data(), frame.data(), frame.size());
+            sink = sink + static_cast<uint32_t>(COBSParser::decodeInPlace(decoded.data(), static_cast<uint32_t>(frame.size()), view));
+        });
+
+        passed &= expectNoAllocations("cobs::decode (vector)", [&]() { sink = sink + static_cast<uint32_t>(cobs::decode(frame.data(), static_cast<uint32_t>(frame.size()), message)); });
+        passed &= expectNoAllocations("decodeBatch", [&]() { sink = sink + parser.decodeBatch(batch.data(), static_cast<uint32_t>(batch.size()), arena, frames); });
+
+        passed &= expectNoAllocations("COBSStreamDecoder::decode", [&]()
+        {
+            sink = sink + streamDecoder.decode(frame.data(), static_cast<uint32_t>(frame.size()), [](const uint8_t*, uint32_t) {});
+        });
+
+        std::printf("%s\n", (passed ? "All steady state paths are allocation free." : "Steady state allocations found."));
+
+        return passed;
+    }
+
+
+    /*
+     * Checks a checksum against its catalogued check value, the checksum of the ASCII string "123456789".
+     * The string is also added in two pieces at every split point, which must give the same checksum.
+     *
+     * @tparam  ChecksumPolicy: Checksum under test.
+     * @param   name: Name printed in the results.
+     * @param   expected: Check value.
+     *
+     * @return  True if every checksum matched the check value.
+     */
+    template <typename ChecksumPolicy>
+    bool
+    expectCheckValue(const char* name, const typename ChecksumPolicy::ValueType expected)
+    {
+        const uint8_t *check = reinterpret_cast<const uint8_t*>("123456789");
+        const size_t checkSize = 9U;
+        const typename ChecksumPolicy::ValueType value = ChecksumPolicy::end(ChecksumPolicy::update(ChecksumPolicy::begin(), check, checkSize));
+        bool passed = (value == expected);
+
+        for (size_t split = 0U; split <= checkSize; ++split)
+        {
+            const typename ChecksumPolicy::ValueType first = ChecksumPolicy::update(ChecksumPolicy::begin(), check, split);
+
+            passed &= (ChecksumPolicy::end(ChecksumPolicy::update(first, (check + split), (checkSize - split))) == expected);
+        }
+
+        std::printf("%-36s 0x%08X  %s\n", name, static_cast<uint32_t>(value), (passed ? "ok" : "FAIL"));
+
+        return passed;
+    }
+
+
+    /*
+     * Checks a hardware CRC kernel gives the same result as the tables for every size up to SELF_TEST_MAX_CRC_SIZE, including sizes below
+     * the kernels own minimum, from unaligned starting positions and random CRC states.
+     *
+     * @param   name: Name printed in the results.
+     * @param   kernel: Kernel under test, called directly rather than through the policy so short inputs reach it.
+     * @param   table: Table implementation of the same CRC.
+     *
+     * @return  True if every result matched.
+     */
+    bool
+    expectKernelMatchesTable(const char* name, uint32_t (*kernel)(const uint32_t, const uint8_t*, const size_t), uint32_t (*table)(uint32_t, const uint8_t*, size_t))
+    {
+        std::mt19937 generator(SELF_TEST_MAX_CRC_SIZE); // Fixed seed so a failure can be reproduced.
+        std::vector<uint8_t> data(SELF_TEST_MAX_CRC_SIZE + 16U);
+        uint32_t mismatches = 0U;
+
+        for (uint8_t& byte : data)
+        {
+            byte = static_cast<uint8_t>(generator());
+        }
+
+        for (uint32_t size = 0U; size <= SELF_TEST_MAX_CRC_SIZE; ++size)
+        {
+            const uint8_t *start = (data.data() + (size % 16U));
+            const uint32_t crc = static_cast<uint32_t>(generator());
+
+            mismatches += ((kernel(crc, start, size) != table(crc, start, size)) ? 1U : 0U);
+        }
+
+        std::printf("%-36s %u mismatches  %s\n", name, mismatches, ((mismatches == 0U) ? "ok" : "FAIL"));
+
+        return (mismatches == 0U);
+    }
+
+
+    /*
+     * Compares an encoded frame with the frame encodeMessage() produced.
+     *
+     * @return  True if both frames are the same size with the same bytes.
+     */
+    bool
+    isSameFrame(const std::vector<uint8_t>& expected, const uint32_t expectedSize, const uint8_t* actual, const uint32_t actualSize)
+    {
+        return ((actualSize == expectedSize) && (std::memcmp(expected.data(), actual, expectedSize) == 0));
+    }
+
+
+    /*
+     * Checks encodeInPlace(), encodeGather() and encodeToSegments() (flattened) produce exactly the frame encodeMessage() does, and that the
+     * frame decodes back to the payload with both decodeMessage() and decodeInPlace(), for every payload size up to MAX_FRAME_SIZE at every
+     * zero density. encodeInPlace() and decodeInPlace() only work while every copy moves forwards and never stores ahead of what it has read
+     * (see cobsKernels.hpp), which this catches.
+     *
+     * @tparam  Codec: Codec under test.
+     * @param   name: Name printed in the results.
+     *
+     * @return  True if every frame matched.
+     */
+    template <typename Codec>
+    bool
+    expectEncodersMatch(const char* name)
+    {
+        std::vector<uint8_t> expected(Codec::MAX_ENCODED_FRAME_SIZE);
+        std::vector<uint8_t> actual(Codec::MAX_ENCODED_FRAME_SIZE);
+        std::vector<uint8_t> scratch(Codec::MAX_ENCODED_FRAME_SIZE);
+        std::vector<COBSIOVec> segments(Codec::MAX_ENCODED_FRAME_SIZE);
+        uint32_t mismatches = 0U;
+
+        for (const ZeroDensity& density : ZERO_DENSITIES)
+        {
+            const std::vector<uint8_t> payload = makePayload(Codec::MAX_FRAME_SIZE, density, Codec::DELIMITER);
+
+            for (uint32_t size = 0U; size <= Codec::MAX_FRAME_SIZE; ++size)
+            {
+                const uint32_t expectedSize = Codec::encodeMessage(payload.data(), size, expected.data(), static_cast<uint32_t>(expected.size()));
+                const uint32_t pieceSize = (size / 3U);
+                const COBSSegment pieces[] = {{payload.data(), pieceSize}, {(payload.data() + pieceSize), pieceSize}, {(payload.data() + (2U * pieceSize)), (size - (2U * pieceSize))}};
+                uint32_t segmentCount = 0U;
+                uint32_t flattenedSize = 0U;
+                uint32_t messageSize = 0U;
+
+                std::memcpy((actual.data() + Codec::ENCODE_HEADROOM), payload.data(), size);
+                mismatches += (isSameFrame(expected, expectedSize, actual.data(), Codec::encodeInPlace(actual.data(), static_cast<uint32_t>(actual.size()), size)) ? 0U : 1U);
+
+                mismatches += (isSameFrame(expected, expectedSize, actual.data(), Codec::encodeGather(pieces, 3U, actual.data(), static_cast<uint32_t>(actual.size()))) ? 0U : 1U);
+
+                const uint32_t segmentedSize = Codec::encodeToSegments(payload.data(), size, segments.data(), static_cast<uint32_t>(segments.size()), scratch.data(),
+                                                                       static_cast<uint32_t>(scratch.size()), segmentCount);
+
+                for (uint32_t i = 0U; i < segmentCount; ++i)
+                {
+                    std::memcpy((actual.data() + flattenedSize), segments[i].iov_base, segments[i].iov_len);
+                    flattenedSize += static_cast<uint32_t>(segments[i].iov_len);
+                }
+
+                mismatches += (((segmentedSize == flattenedSize) && isSameFrame(expected, expectedSize, actual.data(), flattenedSize)) ? 0U : 1U);
+
+                const COBSStatus status = Codec::decodeMessage(expected.data(), expectedSize, actual.data(), static_cast<uint32_t>(actual.size()), messageSize);
+                mismatches += (((status == COBSStatus::OK) && (messageSize == size) && (std::memcmp(actual.data(), payload.data(), size) == 0)) ? 0U : 1U);
+
+                COBSSegment message = {nullptr, 0U};
+                std::memcpy(actual.data(), expected.data(), expectedSize);
+
+                const COBSStatus inPlaceStatus = Codec::decodeInPlace(actual.data(), expectedSize, message);
+                mismatches += (((inPlaceStatus == COBSStatus::OK) && (message.data == actual.data()) && (message.size == size) &&
+                                (std::memcmp(message.data, payload.data(), size) == 0)) ? 0U : 1U);
+            }
+        }
+
+        std::printf("%-36s %u mismatches  %s\n", name, mismatches, ((mismatches == 0U) ? "ok" : "FAIL"));
+
+        return (mismatches == 0U);
+    }
+
+
+    /*
+     * Checks two resync stats are the same.
+     *
+     * @return  True if every counter matches.
+     */
+    bool
+    isSameResyncStats(const COBSResyncStats& expected, const COBSResyncStats& actual)
+    {
+        return ((actual.resyncCount == expected.resyncCount) && (actual.lastDiscardedBytes == expected.lastDiscardedBytes) &&
+                (actual.totalDiscardedBytes == expected.totalDiscardedBytes));
+    }
+
+
+    /*
+     * Checks decodeBatch() and the stream decoder resynchronise after oversized frames, with the input split in two at every position so
+     * the resync state carried between calls is covered too.
+     *
+     * The stream is an oversized frame of exactly MAX_ENCODED_FRAME_SIZE bytes, a good frame of the largest valid size, an oversized frame of
+     * random bytes and a second good frame. Both good messages must come through intact and the resync stats must count both resyncs.
+     *
+     * @tparam  Codec: Codec under test.
+     * @param   name: Name printed in the results.
+     *
+     * @return  True if every split decoded as expected.
+     */
+    template <typename Codec>
+    bool
+    expectResync(const char* name)
+    {
+        std::mt19937 generator(Codec::MAX_ENCODED_FRAME_SIZE); // Fixed seed so a failure can be reproduced.
+        const std::vector<uint8_t> payloads[] = {makePayload(Codec::MAX_FRAME_SIZE, ZERO_DENSITIES[0], Codec::DELIMITER),
+                                                 makePayload((Codec::MAX_FRAME_SIZE / 2U), ZERO_DENSITIES[2], Codec::DELIMITER)};
+        const uint32_t oversizedSizes[] = {Codec::MAX_ENCODED_FRAME_SIZE, (3U * Codec::MAX_ENCODED_FRAME_SIZE)};
+        std::vector<uint8_t> stream;
+        std::vector<uint8_t> frame;
+
+        for (uint32_t i = 0U; i < 2U; ++i)
+        {
+            // The first oversized frame is all one block size bytes, so the stream decoder passes MAX_FRAME_SIZE on its very last byte.
+            for (uint32_t j = 0U; j < oversizedSizes[i]; ++j)
+            {
+                const uint8_t byte = ((i == 0U) ? static_cast<uint8_t>(Codec::DELIMITER ^ 0x01U) : static_cast<uint8_t>(generator()));
+
+                stream.push_back((byte == Codec::DELIMITER) ? static_cast<uint8_t>(byte ^ 0x01U) : byte);
+            }
+
+            stream.push_back(Codec::DELIMITER);
+            Codec::encodeMessage(payloads[i].data(), static_cast<uint32_t>(payloads[i].size()), frame);
+            stream.insert(stream.end(), frame.begin(), frame.end());
+        }
+
+        const uint32_t streamSize = static_cast<uint32_t>(stream.size());
+        const COBSResyncStats expectedStats = {2U, (oversizedSizes[1] + 1U), (static_cast<uint64_t>(oversizedSizes[0]) + oversizedSizes[1] + 2U)};
+        const COBSStatus expectedStatuses[] = {COBSStatus::FRAME_TOO_LARGE, COBSStatus::OK, COBSStatus::FRAME_TOO_LARGE, COBSStatus::OK};
+        uint32_t mismatches = 0U;
+
+        for (uint32_t split = 0U; split <= streamSize; ++split)
+        {
+            Codec parser;
+            BasicCOBSStreamDecoder<Codec> streamDecoder;
+            std::vector<uint8_t> arena;
+            std::vector<COBSFrame> frames;
+            std::vector<COBSStatus> statuses;
+            std::vector<std::vector<uint8_t>> batchMessages;
+            std::vector<std::vector<uint8_t>> streamMessages;
+            const uint32_t chunkSizes[] = {split, (streamSize - split)};
+            uint32_t position = 0U;
+
+            // Whatever decodeBatch() leaves of the first piece is passed in again at the front of the second.
+            for (const uint32_t end : {split, streamSize})
+            {
+                position += parser.decodeBatch((stream.data() + position), (end - position), arena, frames);
+
+                for (const COBSFrame& entry : frames)
+                {
+                    statuses.push_back(entry.status);
+
+                    if (entry.status == COBSStatus::OK)
+                    {
+                        batchMessages.emplace_back((arena.data() + entry.offset), (arena.data() + entry.offset + entry.size));
+                    }
+                }
+            }
+
+            for (uint32_t chunk = 0U, offset = 0U; chunk < 2U; offset += chunkSizes[chunk++])
+            {
+                streamDecoder.decode((stream.data() + offset), chunkSizes[chunk], [&](const uint8_t* message, const uint32_t messageSize)
+                {
+                    streamMessages.emplace_back(message, (message + messageSize));
+                });
+            }
+
+            const bool batchPassed = ((position == streamSize) && std::equal(std::begin(expectedStatuses), std::end(expectedStatuses), statuses.begin(), statuses.end()) &&
+                                      std::equal(std::begin(payloads), std::end(payloads), batchMessages.begin(), batchMessages.end()) &&
+                                      isSameResyncStats(expectedStats, parser.getResyncStats()));
+            const bool streamPassed = (std::equal(std::begin(payloads), std::end(payloads), streamMessages.begin(), streamMessages.end()) &&
+                                       isSameResyncStats(expectedStats, streamDecoder.getResyncStats()));
+
+            mismatches += ((batchPassed ? 0U : 1U) + (streamPassed ? 0U : 1U));
+        }
+
+        std::printf("%-36s %u mismatches  %s\n", name, mismatches, ((mismatches == 0U) ? "ok" : "FAIL"));
+
+        return (mismatches == 0U);
+    }
+
+
+    /*
+     * Corrupts an encoded frame so decodeMessage() rejects it, by flipping a bit from the middle of the frame onwards.
+     *
+     * @tparam  Codec: Codec the frame was encoded with.
+     * @param   frame: Frame to corrupt, including its DELIMITER.
+     */
+    template <typename Codec>
+    void
+    corruptFrame(std::vector<uint8_t>& frame)
+    {
+        std::vector<uint8_t> message;
+
+        for (size_t i = (frame.size() / 2U); (i + 1U) < frame.size(); ++i)
+        {
+            const uint8_t original = frame[i];
+            const uint8_t mask = (((original ^ 0x01U) == Codec::DELIMITER) ? 0x02U : 0x01U); // Never create a DELIMITER, which would split the frame.
+
+            frame[i] = static_cast<uint8_t>(original ^ mask);
+
+            if (cobs::decode<Codec>(frame.data(), static_cast<uint32_t>(frame.size()), message) != COBSStatus::OK)
+            {
+                return;
+            }
+
+            frame[i] = original;
+        }
+    }
+
+
+    /*
+     * Checks the stream decoder passes exactly the expected messages to its callback when a stream of back to back frames arrives in
+     * random sized chunks, from one byte at a time up to several frames at once.
+     *
+     * The stream mixes every zero density and message size up to MAX_FRAME_SIZE with empty frames, corrupted frames and frames cut short in
+     * the middle of a block, none of which may reach the callback or disturb the frames after them.
+     *
+     * @tparam  Codec: Codec under test.
+     * @param   name: Name printed in the results.
+     *
+     * @return  True if every message matched.
+     */
+    template <typename Codec>
+    bool
+    expectStreamDecoder(const char* name)
+    {
+        std::mt19937 generator(Codec::MAX_FRAME_SIZE); // Fixed seed so a failure can be reproduced.
+        std::uniform_int_distribution<uint32_t> sizeDistribution(0U, Codec::MAX_FRAME_SIZE);
+        std::vector<uint8_t> stream;
+        std::vector<std::vector<uint8_t>> expected; // Messages which must reach the callback, in order.
+        std::vector<uint8_t> frame;
+        uint32_t mismatches = 0U;
+
+        for (uint32_t i = 0U; i < SELF_TEST_FRAME_COUNT; ++i)
+        {
+            const bool isCutShort = ((i % 8U) == 5U);
+            const uint32_t size = (isCutShort ? Codec::MAX_FRAME_SIZE : sizeDistribution(generator));
+            const ZeroDensity& density = (isCutShort ? ZERO_DENSITIES[0] : ZERO_DENSITIES[i % (sizeof(ZERO_DENSITIES) / sizeof(ZERO_DENSITIES[0]))]);
+            std::vector<uint8_t> payload(size);
+            uint32_t cutSize = 32U; // Payload bytes kept by a frame cut short, which are followed by a copy of their CRC.
+
+            fillPayload(payload.data(), size, density, generator, Codec::DELIMITER);
+
+            if (isCutShort)
+            {
+                // The cut frame ends on what looks like a matching CRC, so only the check that it ends on a block boundary can reject it.
+                // A CRC holding the DELIMITER would end the block there, so the cut moves on until it does not.
+                using ChecksumPolicy = typename Codec::ChecksumPolicyType;
+
+                for (;; ++cutSize)
+                {
+                    uint8_t *crcBytes = (payload.data() + cutSize);
+
+                    cobs::storeChecksum(ChecksumPolicy::end(ChecksumPolicy::update(ChecksumPolicy::begin(), payload.data(), cutSize)), crcBytes);
+
+                    if (std::find(crcBytes, (crcBytes + Codec::CRC_SIZE), Codec::DELIMITER) == (crcBytes + Codec::CRC_SIZE))
+                    {
+                        break;
+                    }
+                }
+            }
+
+            Codec::encodeMessage(payload.data(), size, frame);
+
+            if ((i % 8U) == 3U)
+            {
+                corruptFrame<Codec>(frame);
+            }
+            else if (isCutShort)
+            {
+                // The first block holds the whole delimiter free payload up to MAX_BLOCK_SIZE, so this ends the frame part way through it.
+                frame.resize(1U + cutSize + Codec::CRC_SIZE);
+                frame.push_back(Codec::DELIMITER);
+            }
+            else
+            {
+                expected.push_back(payload);
+            }
+
+            if ((i % 8U) == 7U)
+            {
+                stream.push_back(Codec::DELIMITER); // Empty frame.
+            }
+
+            stream.insert(stream.end(), frame.begin(), frame.end());
+        }
+
+        for (uint32_t round = 0U; round < SELF_TEST_CHUNK_ROUNDS; ++round)
+        {
+            std::uniform_int_distribution<uint32_t> chunkDistribution(1U, (1U << round));
+            BasicCOBSStreamDecoder<Codec> streamDecoder;
+            std::vector<std::vector<uint8_t>> messages;
+            uint32_t messageCount = 0U;
+
+            for (size_t position = 0U; position < stream.size();)
+            {
+                const uint32_t chunkSize = static_cast<uint32_t>(std::min<size_t>(chunkDistribution(generator), (stream.size() - position)));
+
+                messageCount += streamDecoder.decode((stream.data() + position), chunkSize, [&](const uint8_t* message, const uint32_t messageSize)
+                {
+                    messages.emplace_back(message, (message + messageSize));
+                });
+
+                position += chunkSize;
+            }
+
+            mismatches += (((messages == expected) && (messageCount == expected.size()) && isSameResyncStats({}, streamDecoder.getResyncStats())) ? 0U : 1U);
+        }
+
+        std::printf("%-36s %u mismatches  %s\n", name, mismatches, ((mismatches == 0U) ? "ok" : "FAIL"));
+
+        return (mismatches == 0U);
+    }
+
+
+    /*
+     * Checks the frame table decodeBatch() builds for a buffer of back to back frames ending in a partial frame.
+     *
+     * The batch mixes every zero density and message size up to MAX_FRAME_SIZE with corrupted frames and empty frames. Every entry must have
+     * the status decodeMessage() gives its frame, and a validated message must sit in the arena at its offset, straight after the message
+     * before it. Empty frames must be skipped, and the return value must be the start of the partial frame, which must then decode once
+     * its DELIMITER is passed in with it.
+     *
+     * @tparam  Codec: Codec under test.
+     * @param   name: Name printed in the results.
+     *
+     * @return  True if every frame matched.
+     */
+    template <typename Codec>
+    bool
+    expectBatchDecode(const char* name)
+    {
+        std::mt19937 generator(Codec::MAX_ENCODED_FRAME_SIZE); // Fixed seed so a failure can be reproduced.
+        std::uniform_int_distribution<uint32_t> sizeDistribution(0U, Codec::MAX_FRAME_SIZE);
+        std::vector<uint8_t> batch;
+        std::vector<COBSStatus> expectedStatuses; // Status of each frame which must appear in the frame table, in order.
+        std::vector<std::vector<uint8_t>> expectedMessages; // Message of each entry expected to be validated, in order.
+        std::vector<uint8_t> frame;
+        std::vector<uint8_t> message;
+        uint32_t mismatches = 0U;
+
+        // One more frame than the rest is encoded, which is left without its DELIMITER as the trailing partial frame.
+        for (uint32_t i = 0U; i <= SELF_TEST_FRAME_COUNT; ++i)
+        {
+            const uint32_t size = sizeDistribution(generator);
+            std::vector<uint8_t> payload(size);
+
+            fillPayload(payload.data(), size, ZERO_DENSITIES[i % (sizeof(ZERO_DENSITIES) / sizeof(ZERO_DENSITIES[0]))], generator, Codec::DELIMITER);
+            Codec::encodeMessage(payload.data(), size, frame);
+
+            if (i == SELF_TEST_FRAME_COUNT)
+            {
+                expectedMessages.push_back(payload);
+                frame.pop_back();
+            }
+            else
+            {
+                if ((i % 8U) == 3U)
+                {
+                    corruptFrame<Codec>(frame);
+                }
+
+                if ((i % 8U) == 7U)
+                {
+                    batch.push_back(Codec::DELIMITER); // Empty frame.
+                }
+
+                expectedStatuses.push_back(cobs::decode<Codec>(frame.data(), static_cast<uint32_t>(frame.size()), message));
+
+                if (expectedStatuses.back() == COBSStatus::OK)
+                {
+                    expectedMessages.push_back(payload);
+                }
+            }
+
+            batch.insert(batch.end(), frame.begin(), frame.end());
+        }
+
+        const uint32_t partialPosition = static_cast<uint32_t>(batch.size() - frame.size());
+        Codec parser;
+        std::vector<uint8_t> arena;
+        std::vector<COBSFrame> frames;
+        uint32_t arenaSize = 0U;
+        uint32_t messageIndex = 0U;
+
+        mismatches += ((parser.decodeBatch(batch.data(), static_cast<uint32_t>(batch.size()), arena, frames) == partialPosition) ? 0U : 1U);
+        mismatches += ((frames.size() == expectedStatuses.size()) ? 0U : 1U);
+
+        for (uint32_t i = 0U; i < std::min(frames.size(), expectedStatuses.size()); ++i)
+        {
+            const COBSFrame& entry = frames[i];
+            bool passed = ((entry.status == expectedStatuses[i]) && (entry.offset == arenaSize));
+
+            if (entry.status == COBSStatus::OK)
+            {
+                const std::vector<uint8_t>& expectedMessage = expectedMessages[messageIndex++];
+
+                passed &= ((entry.size == expectedMessage.size()) && std::equal(expectedMessage.begin(), expectedMessage.end(), (arena.data() + entry.offset)));
+                arenaSize += entry.size;
+            }
+            else
+            {
+                passed &= (entry.size == 0U);
+            }
+
+            mismatches += (passed ? 0U : 1U);
+        }
+
+        // The partial frame is completed by its DELIMITER, so the whole of the second batch is consumed.
+        std::vector<uint8_t> rest((batch.begin() + partialPosition), batch.end());
+        rest.push_back(Codec::DELIMITER);
+
+        const std::vector<uint8_t>& partialMessage = expectedMessages.back();
+        const bool partialPassed = ((parser.decodeBatch(rest.data(), static_cast<uint32_t>(rest.size()), arena, frames) == rest.size()) && (frames.size() == 1U) &&
+                                    (frames[0].status == COBSStatus::OK) && (frames[0].offset == 0U) && (frames[0].size == partialMessage.size()) &&
+                                    std::equal(partialMessage.begin(), partialMessage.end(), arena.data()));
+
+        mismatches += ((messageIndex == (expectedMessages.size() - 1U)) ? 0U : 1U);
+        mismatches += (partialPassed ? 0U : 1U);
+
+        std::printf("%-36s %u mismatches  %s\n", name, mismatches, ((mismatches == 0U) ? "ok" : "FAIL"));
+
+        return (mismatches == 0U);
+    }
+
+
+    /*
+     * Checks every checksum against its check value, the hardware CRC kernels against the tables, every encoder against encodeMessage()
+     * the resync after oversized frames, the stream decoder and the decodeBatch() frame table, for the kernel level in use.
+     *
+     * @return  True if every check passed.
+     */
+    bool
+    runSelfTest(void)
+    {
+        bool passed = true;
+
+        std::printf("kernels: %s\n", cobs::dispatch::getKernelLevelName(cobs::dispatch::getKernelLevel()));
+
+        passed &= expectCheckValue<cobs::XORChecksum>("XORChecksum", 0x31U);
+        passed &= expectCheckValue<cobs::CRC8>("CRC8", 0xF4U);
+        passed &= expectCheckValue<cobs::CRC16CCITT>("CRC16CCITT", 0x29B1U);
+        passed &= expectCheckValue<cobs::CRC32Table>("CRC32Table", 0xCBF43926U);
+        passed &= expectCheckValue<cobs::CRC32>("CRC32", 0xCBF43926U);
+        passed &= expectCheckValue<cobs::CRC32CTable>("CRC32CTable", 0xE3069283U);
+        passed &= expectCheckValue<cobs::CRC32C>("CRC32C", 0xE3069283U);
+
+        passed &= expectKernelMatchesTable("kernels::updateCRC32", cobs::kernels::updateCRC32, cobs::CRC32Table::update);
+        passed &= expectKernelMatchesTable("kernels::updateCRC32C", cobs::kernels::updateCRC32C, cobs::CRC32CTable::update);
+
+        passed &= expectEncodersMatch<COBSParser>("encoders (0x00, XOR)");
+        passed &= expectEncodersMatch<BasicCOBSCodec<COBSParser::MAX_FRAME_SIZE, 0x7EU, cobs::CRC32>>("encoders (0x7E, CRC32)");
+
+        passed &= expectResync<BasicCOBSCodec<64U>>("resync (64, 0x00, XOR)");
+        passed &= expectResync<BasicCOBSCodec<64U, 0x7EU, cobs::CRC32>>("resync (64, 0x7E, CRC32)");
+
+        passed &= expectStreamDecoder<COBSParser>("stream decoder (0x00, XOR)");
+        passed &= expectStreamDecoder<BasicCOBSCodec<COBSParser::MAX_FRAME_SIZE, 0x7EU, cobs::CRC32>>("stream decoder (0x7E, CRC32)");
+
+        passed &= expectBatchDecode<COBSParser>("decodeBatch (0x00, XOR)");
+        passed &= expectBatchDecode<BasicCOBSCodec<COBSParser::MAX_FRAME_SIZE, 0x7EU, cobs::CRC32>>("decodeBatch (0x7E, CRC32)");
+
+        std::printf("%s\n", (passed ? "All self tests passed." : "Self test failures found."));
+
+        return passed;
+    }
+}
+
+
+// Counting replacements for the global allocation functions, see allocationCount.
+void*
+operator new(std::size_t size)
+{
+    allocationCount++;
+
+    void *memory = std::malloc((size > 0U) ? size : 1U);
+
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+
+// GCC cannot see these replacements allocate with malloc, so once inlined it reports every free() as mismatched.
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+
+int
+main(int argc, char* argv[])
+{
+    const char *checksum = ((argc > 1) ? argv[1] : "xor");
+
+    if (std::strcmp(checksum, "--alloc-check") == 0)
+    {
+        return (checkAllocations() ? 0 : 1);
+    }
+
+    if (std::strcmp(checksum, "--self-test") == 0)
+    {
+        return (runSelfTest() ? 0 : 1);
+    }
+
+    PerfCounters counters;
+
+    std::printf("checksum: %s, kernels: %s, hardware counters: %s\n", checksum, cobs::dispatch::getKernelLevelName(cobs::dispatch::getKernelLevel()),
+                (counters.isAvailable() ? "on" : "off"));
+
+    if (std::strcmp(checksum, "xor") == 0)
+    {
+        runSuite<cobs::XORChecksum>(counters, true);
+    }
+    else if (std::strcmp(checksum, "crc8") == 0)
+    {
+        runSuite<cobs::CRC8>(counters, false);
+    }
+    else if (std::strcmp(checksum, "crc16") == 0)
+    {
+        runSuite<cobs::CRC16CCITT>(counters, false);
+    }
+    else if (std::strcmp(checksum, "crc32") == 0)
+    {
+        runSuite<cobs::CRC32>(counters, false);
+    }
+    else if (std::strcmp(checksum, "crc32c") == 0)
+    {
+        runSuite<cobs::CRC32C>(counters, false);
+    }
+    else
+    {
+        std::fprintf(stderr, "Unknown checksum %s, expected xor, crc8, crc16, crc32 or crc32c.\n", checksum);
+        return 1;
+    }
+
+    return 0;
+}
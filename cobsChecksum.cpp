@@ -0,0 +1,347 @@
+// Standard Libraries.
+#include <atomic>
+
+// Application Libraries.
+#include "cobsChecksum.hpp"
+#include "cobsDispatch.hpp"
+
+// The hardware kernels rely on GCC/Clang function multiversioning attributes and builtins.
+#if (defined(__GNUC__) && defined(__x86_64__))
+    #define COBS_X86_CRC_KERNELS
+    #include <immintrin.h>
+#endif
+
+
+namespace
+{
+    using CRCKernel = uint32_t (*)(const uint32_t, const uint8_t*, const size_t);
+
+
+#if defined(COBS_X86_CRC_KERNELS)
+    constexpr uint32_t CRC32C_POLYNOMIAL = 0x82F63B78U; // Bit reversed CRC-32C polynomial.
+    constexpr size_t CRC32C_STREAM_SIZE = 128U; // Bytes handled by each of the three interleaved crc32 streams per iteration.
+
+
+    /*
+     * Multiplies two polynomials modulo the CRC-32C polynomial, in the bit reversed representation used by the CRC (bit 31 is x^0).
+     *
+     * @param   a: First polynomial.
+     * @param   b: Second polynomial.
+     *
+     * @return  a * b modulo the polynomial.
+     */
+    constexpr uint32_t
+    multiplyModulo(const uint32_t a, uint32_t b)
+    {
+        uint32_t product = 0U;
+
+        for (uint32_t bit = 0x80000000U; bit != 0U; bit >>= 1U)
+        {
+            if (a & bit)
+            {
+                product ^= b;
+            }
+
+            b = ((b & 1U) ? ((b >> 1U) ^ CRC32C_POLYNOMIAL) : (b >> 1U)); // b *= x.
+        }
+
+        return product;
+    }
+
+
+    /*
+     * Calculates x^(8 * size) modulo the polynomial, multiplying a CRC by this is the same as feeding it size zero bytes.
+     *
+     * @param   size: Number of zero bytes.
+     *
+     * @return  The shift operator.
+     */
+    constexpr uint32_t
+    zeroBytesOperator(size_t size)
+    {
+        uint32_t result = 0x80000000U; // x^0.
+        uint32_t square = 0x00800000U; // x^8, one zero byte.
+
+        for (; size > 0U; size >>= 1U)
+        {
+            if (size & 1U)
+            {
+                result = multiplyModulo(result, square);
+            }
+
+            square = multiplyModulo(square, square);
+        }
+
+        return result;
+    }
+
+
+    using ShiftTable = std::array<std::array<uint32_t, 256U>, 4U>;
+
+    /*
+     * Builds the tables which shift a CRC past size zero bytes with one lookup per CRC byte. Generated at compile time.
+     *
+     * @param   size: Number of zero bytes to shift past.
+     *
+     * @return  The tables, table[k][n] is the shifted value of byte n in byte position k of the CRC.
+     */
+    constexpr ShiftTable
+    makeShiftTable(const size_t size)
+    {
+        const uint32_t shiftOperator = zeroBytesOperator(size);
+        ShiftTable table{};
+
+        for (uint32_t k = 0U; k < 4U; ++k)
+        {
+            for (uint32_t n = 0U; n < 256U; ++n)
+            {
+                table[k][n] = multiplyModulo((n << (8U * k)), shiftOperator);
+            }
+        }
+
+        return table;
+    }
+
+    constexpr ShiftTable CRC32C_SHIFT_ONE_STREAM = makeShiftTable(CRC32C_STREAM_SIZE);
+    constexpr ShiftTable CRC32C_SHIFT_TWO_STREAMS = makeShiftTable(2U * CRC32C_STREAM_SIZE);
+
+
+    /*
+     * Shifts a CRC past the zero bytes the table was built for.
+     *
+     * @param   table: Shift table.
+     * @param   crc: CRC to shift.
+     *
+     * @return  The shifted CRC.
+     */
+    inline uint32_t
+    shiftCRC(const ShiftTable& table, const uint32_t crc)
+    {
+        return (table[0][crc & 0xFFU] ^ table[1][(crc >> 8U) & 0xFFU] ^ table[2][(crc >> 16U) & 0xFFU] ^ table[3][crc >> 24U]);
+    }
+
+
+    /*
+     * CRC-32C using the SSE4.2 crc32 instruction.
+     *
+     * The instruction has a latency of three cycles but can start one per cycle, so large inputs are split into three streams which are calculated
+     * side by side and then combined by shifting the first two streams past the data that follows them.
+     *
+     * @param   crc: Current CRC state.
+     * @param   data: Data to add to the CRC.
+     * @param   size: Total number of bytes in data.
+     *
+     * @return  The updated CRC state.
+     */
+    __attribute__((target("sse4.2")))
+    uint32_t
+    updateCRC32CSSE42(const uint32_t crc, const uint8_t* data, size_t size)
+    {
+        uint64_t crc0 = crc;
+
+        for (; size >= (3U * CRC32C_STREAM_SIZE); size -= (3U * CRC32C_STREAM_SIZE))
+        {
+            uint64_t crc1 = 0U;
+            uint64_t crc2 = 0U;
+            const uint8_t *streamEnd = (data + CRC32C_STREAM_SIZE);
+
+            for (; data < streamEnd; data += 8U)
+            {
+                crc0 = _mm_crc32_u64(crc0, cobs::loadLittleEndian64(data));
+                crc1 = _mm_crc32_u64(crc1, cobs::loadLittleEndian64(data + CRC32C_STREAM_SIZE));
+                crc2 = _mm_crc32_u64(crc2, cobs::loadLittleEndian64(data + (2U * CRC32C_STREAM_SIZE)));
+            }
+
+            crc0 = (shiftCRC(CRC32C_SHIFT_TWO_STREAMS, static_cast<uint32_t>(crc0)) ^ shiftCRC(CRC32C_SHIFT_ONE_STREAM, static_cast<uint32_t>(crc1)) ^ crc2);
+            data += (2U * CRC32C_STREAM_SIZE); // The loop above only advanced through the first stream.
+        }
+
+        for (; size >= 8U; size -= 8U, data += 8U)
+        {
+            crc0 = _mm_crc32_u64(crc0, cobs::loadLittleEndian64(data));
+        }
+
+        uint32_t result = static_cast<uint32_t>(crc0);
+
+        for (; size > 0U; --size)
+        {
+            result = _mm_crc32_u8(result, *data++);
+        }
+
+        return result;
+    }
+
+
+    /*
+     * CRC-32 using PCLMULQDQ carry-less multiplication to fold 64 bytes at a time, then Barrett reduction down to 32 bits.
+     * This follows Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+     *
+     * @param   crc: Current CRC state.
+     * @param   data: Data to add to the CRC.
+     * @param   size: Total number of bytes in data.
+     *
+     * @return  The updated CRC state.
+     */
+    __attribute__((target("pclmul,sse4.1")))
+    uint32_t
+    updateCRC32PCLMUL(const uint32_t crc, const uint8_t* data, size_t size)
+    {
+        // The folding needs a full 64 bytes to start with.
+        if (size < 64U)
+        {
+            return cobs::CRC32Table::update(crc, data, size);
+        }
+
+        const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596LL, 0x0154442BD4LL); // x^(4*128+32) and x^(4*128-32) mod P, fold by 4 x 128 bits.
+        const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009ELL, 0x01751997D0LL); // x^(128+32) and x^(128-32) mod P, fold by 128 bits.
+        const __m128i k5 = _mm_set_epi64x(0x0LL, 0x0163CD6124LL); // x^64 mod P, fold 64 bits down to 32.
+        const __m128i polynomial = _mm_set_epi64x(0x01F7011641LL, 0x01DB710641LL); // Barrett constant and the bit reversed polynomial.
+        const __m128i lowMask = _mm_setr_epi32(-1, 0, -1, 0);
+
+        const __m128i *chunk = reinterpret_cast<const __m128i*>(data);
+        __m128i x1 = _mm_xor_si128(_mm_loadu_si128(chunk + 0), _mm_cvtsi32_si128(static_cast<int>(crc)));
+        __m128i x2 = _mm_loadu_si128(chunk + 1);
+        __m128i x3 = _mm_loadu_si128(chunk + 2);
+        __m128i x4 = _mm_loadu_si128(chunk + 3);
+        data += 64U;
+        size -= 64U;
+
+        // Fold four 128 bit lanes forward by 512 bits per iteration.
+        for (; size >= 64U; size -= 64U, data += 64U)
+        {
+            chunk = reinterpret_cast<const __m128i*>(data);
+
+            x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k1k2, 0x00), _mm_clmulepi64_si128(x1, k1k2, 0x11)), _mm_loadu_si128(chunk + 0));
+            x2 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x2, k1k2, 0x00), _mm_clmulepi64_si128(x2, k1k2, 0x11)), _mm_loadu_si128(chunk + 1));
+            x3 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x3, k1k2, 0x00), _mm_clmulepi64_si128(x3, k1k2, 0x11)), _mm_loadu_si128(chunk + 2));
+            x4 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x4, k1k2, 0x00), _mm_clmulepi64_si128(x4, k1k2, 0x11)), _mm_loadu_si128(chunk + 3));
+        }
+
+        // Fold the four lanes into one.
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x00), _mm_clmulepi64_si128(x1, k3k4, 0x11)), x2);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x00), _mm_clmulepi64_si128(x1, k3k4, 0x11)), x3);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x00), _mm_clmulepi64_si128(x1, k3k4, 0x11)), x4);
+
+        // Fold any remaining whole 128 bit blocks.
+        for (; size >= 16U; size -= 16U, data += 16U)
+        {
+            x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x00), _mm_clmulepi64_si128(x1, k3k4, 0x11)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+        }
+
+        // Fold 128 bits down to 64.
+        __m128i x2Fold = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+        x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2Fold);
+
+        // Fold 64 bits down to 32.
+        x2Fold = _mm_srli_si128(x1, 4);
+        x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, lowMask), k5, 0x00), x2Fold);
+
+        // Barrett reduction to the final 32 bit CRC.
+        x2Fold = _mm_clmulepi64_si128(_mm_and_si128(x1, lowMask), polynomial, 0x10);
+        x2Fold = _mm_clmulepi64_si128(_mm_and_si128(x2Fold, lowMask), polynomial, 0x00);
+        x1 = _mm_xor_si128(x1, x2Fold);
+
+        const uint32_t result = static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+
+        return cobs::CRC32Table::update(result, data, size); // Less than 16 bytes remain, finish these using the tables.
+    }
+#endif
+
+
+    /*
+     * Picks the fastest CRC-32 kernel for the dispatch level, see cobsDispatch.hpp.
+     *
+     * @return  The selected kernel.
+     */
+    CRCKernel
+    selectCRC32(void)
+    {
+#if defined(COBS_X86_CRC_KERNELS)
+        if (cobs::dispatch::hasCarrylessMultiply())
+        {
+            return updateCRC32PCLMUL;
+        }
+#endif
+
+        return cobs::CRC32Table::update;
+    }
+
+
+    /*
+     * Picks the fastest CRC-32C kernel for the dispatch level, see cobsDispatch.hpp.
+     *
+     * @return  The selected kernel.
+     */
+    CRCKernel
+    selectCRC32C(void)
+    {
+#if defined(COBS_X86_CRC_KERNELS)
+        if (cobs::dispatch::getKernelLevel() >= cobs::dispatch::KernelLevel::SSE42)
+        {
+            return updateCRC32CSSE42;
+        }
+#endif
+
+        return cobs::CRC32CTable::update;
+    }
+
+
+    uint32_t updateCRC32Resolve(const uint32_t crc, const uint8_t* data, const size_t size);
+    uint32_t updateCRC32CResolve(const uint32_t crc, const uint8_t* data, const size_t size);
+
+    // Start out pointing at the resolvers, which replace them with the selected kernels on first use.
+    std::atomic<CRCKernel> crc32Kernel(updateCRC32Resolve);
+    std::atomic<CRCKernel> crc32cKernel(updateCRC32CResolve);
+
+
+    uint32_t
+    updateCRC32Resolve(const uint32_t crc, const uint8_t* data, const size_t size)
+    {
+        const CRCKernel kernel = selectCRC32();
+        crc32Kernel.store(kernel, std::memory_order_relaxed);
+
+        return kernel(crc, data, size);
+    }
+
+
+    uint32_t
+    updateCRC32CResolve(const uint32_t crc, const uint8_t* data, const size_t size)
+    {
+        const CRCKernel kernel = selectCRC32C();
+        crc32cKernel.store(kernel, std::memory_order_relaxed);
+
+        return kernel(crc, data, size);
+    }
+}
+
+
+/*
+ * Adds data to a CRC-32 state using the fastest kernel supported by the CPU.
+ *
+ * @param   crc: Current CRC state.
+ * @param   data: Data to add to the CRC.
+ * @param   size: Total number of bytes in data.
+ *
+ * @return  The updated CRC state.
+ */
+uint32_t
+cobs::kernels::updateCRC32(const uint32_t crc, const uint8_t* data, const size_t size)
+{
+    return crc32Kernel.load(std::memory_order_relaxed)(crc, data, size);
+}
+
+
+/*
+ * Adds data to a CRC-32C state using the fastest kernel supported by the CPU.
+ *
+ * @param   crc: Current CRC state.
+ * @param   data: Data to add to the CRC.
+ * @param   size: Total number of bytes in data.
+ *
+ * @return  The updated CRC state.
+ */
+uint32_t
+cobs::kernels::updateCRC32C(const uint32_t crc, const uint8_t* data, const size_t size)
+{
+    return crc32cKernel.load(std::memory_order_relaxed)(crc, data, size);
+}
@@ -0,0 +1,285 @@
+#pragma once
+
+// Standard Libraries.
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Application Libraries.
+#include "cobsEndian.hpp"
+
+
+/*
+ * Checksum policies used to validate COBS frames, selected with the ChecksumPolicy template parameter of BasicCOBSCodec.
+ *
+ * Every policy provides:
+ *      ValueType:  Type holding the checksum.
+ *      SIZE:       Number of checksum bytes appended to each frame (little endian).
+ *      begin():    Initial checksum state.
+ *      update():   Adds data to the checksum state, this can be called repeatedly to checksum data in pieces.
+ *      end():      Turns the checksum state into the checksum value sent in the frame.
+ */
+namespace cobs
+{
+    /*
+     * Writes a checksum to the frame, least significant byte first.
+     *
+     * @param   value: Checksum to write.
+     * @param   output: Location to write the checksum bytes to.
+     */
+    template <typename T>
+    inline void
+    storeChecksum(const T value, uint8_t* output)
+    {
+        for (uint32_t i = 0U; i < sizeof(T); ++i)
+        {
+            output[i] = static_cast<uint8_t>(value >> (8U * i));
+        }
+    }
+
+
+    /*
+     * Reads a checksum written by storeChecksum().
+     *
+     * @param   input: Location of the checksum bytes.
+     *
+     * @return  The checksum.
+     */
+    template <typename T>
+    inline T
+    loadChecksum(const uint8_t* input)
+    {
+        T value = 0U;
+
+        for (uint32_t i = 0U; i < sizeof(T); ++i)
+        {
+            value = static_cast<T>(value | (static_cast<T>(input[i]) << (8U * i)));
+        }
+
+        return value;
+    }
+
+
+    /*
+     * XOR of every byte, the original COBSParser checksum. Very cheap, but it misses any even number of flips in the same bit position.
+     */
+    struct XORChecksum
+    {
+        using ValueType = uint8_t;
+
+        static constexpr uint32_t SIZE = 1U;
+
+        static constexpr ValueType begin(void) { return 0U; }
+        static constexpr ValueType end(const ValueType checksum) { return checksum; }
+
+        /*
+         * @param   checksum: Current checksum state.
+         * @param   data: Data to add to the checksum.
+         * @param   size: Total number of bytes in data.
+         *
+         * @return  The updated checksum state.
+         */
+        static ValueType
+        update(const ValueType checksum, const uint8_t* data, size_t size)
+        {
+            uint64_t wideChecksum = 0U; // XOR is independent of byte position, so 8 bytes are combined at a time and folded down at the end.
+
+            for (; size >= 8U; size -= 8U, data += 8U)
+            {
+                wideChecksum ^= loadLittleEndian64(data);
+            }
+
+            wideChecksum ^= (wideChecksum >> 32U);
+            wideChecksum ^= (wideChecksum >> 16U);
+            wideChecksum ^= (wideChecksum >> 8U);
+
+            ValueType result = static_cast<ValueType>(checksum ^ static_cast<ValueType>(wideChecksum));
+
+            for (; size > 0U; --size)
+            {
+                result ^= *data++;
+            }
+
+            return result;
+        }
+    };
+
+
+    /*
+     * Table driven CRC using slicing-by-8, eight bytes are folded into the CRC per iteration with eight table lookups.
+     * The tables are generated at compile time.
+     *
+     * @tparam  T: Type holding the CRC, its width is the width of the CRC (8, 16 or 32 bits).
+     * @tparam  Polynomial: Generator polynomial, given bit reversed when Reflected is true.
+     * @tparam  Initial: Initial CRC value.
+     * @tparam  FinalXOR: Value XORed with the CRC once all data has been processed.
+     * @tparam  Reflected: True if data is processed least significant bit first.
+     */
+    template <typename T, T Polynomial, T Initial, T FinalXOR, bool Reflected>
+    class TableCRC
+    {
+        public:
+            using ValueType = T;
+
+            static constexpr uint32_t SIZE = sizeof(T);
+
+            static constexpr ValueType begin(void) { return Initial; }
+            static constexpr ValueType end(const ValueType crc) { return static_cast<ValueType>(crc ^ FinalXOR); }
+
+            static ValueType update(ValueType crc, const uint8_t* data, size_t size);
+
+        private:
+            static constexpr uint32_t WIDTH = (8U * sizeof(T));
+
+            using Table = std::array<std::array<T, 256U>, 8U>;
+
+            /*
+             * Advances the CRC by one byte using the first table.
+             *
+             * @param   table: Table to use, passed in so this can also be used while generating the tables.
+             * @param   crc: Current CRC.
+             * @param   byte: Next byte of data.
+             *
+             * @return  The updated CRC.
+             */
+            static constexpr T
+            updateByte(const Table& table, const T crc, const uint8_t byte)
+            {
+                if (Reflected)
+                {
+                    return static_cast<T>((static_cast<uint32_t>(crc) >> 8U) ^ table[0][(crc ^ byte) & 0xFFU]);
+                }
+                else
+                {
+                    return static_cast<T>((static_cast<uint32_t>(crc) << 8U) ^ table[0][((crc >> (WIDTH - 8U)) ^ byte) & 0xFFU]);
+                }
+            }
+
+            /*
+             * Builds the slicing-by-8 tables. table[0][n] is the CRC of byte n, table[k][n] is the CRC of byte n followed by k zero bytes.
+             *
+             * @return  The tables.
+             */
+            static constexpr Table
+            makeTable(void)
+            {
+                Table table{};
+
+                for (uint32_t n = 0U; n < 256U; ++n)
+                {
+                    uint32_t crc = (Reflected ? n : (n << (WIDTH - 8U)));
+
+                    for (uint32_t bit = 0U; bit < 8U; ++bit)
+                    {
+                        if (Reflected)
+                        {
+                            crc = ((crc & 1U) ? ((crc >> 1U) ^ Polynomial) : (crc >> 1U));
+                        }
+                        else
+                        {
+                            crc = ((crc & (1UL << (WIDTH - 1U))) ? ((crc << 1U) ^ Polynomial) : (crc << 1U));
+                        }
+                    }
+
+                    table[0][n] = static_cast<T>(crc);
+                }
+
+                for (uint32_t k = 1U; k < 8U; ++k)
+                {
+                    for (uint32_t n = 0U; n < 256U; ++n)
+                    {
+                        table[k][n] = updateByte(table, table[k - 1U][n], 0U);
+                    }
+                }
+
+                return table;
+            }
+
+            static constexpr Table TABLE = makeTable();
+    };
+
+
+    /*
+     * @param   crc: Current CRC state.
+     * @param   data: Data to add to the CRC.
+     * @param   size: Total number of bytes in data.
+     *
+     * @return  The updated CRC state.
+     */
+    template <typename T, T Polynomial, T Initial, T FinalXOR, bool Reflected>
+    T
+    TableCRC<T, Polynomial, Initial, FinalXOR, Reflected>::update(T crc, const uint8_t* data, size_t size)
+    {
+        for (; size >= 8U; size -= 8U, data += 8U)
+        {
+            /*
+             * Merge the CRC into the first bytes of the word, then look up each byte in the table for its distance from the end of the word.
+             * Reflected CRCs consume the word least significant byte first, the others most significant byte first.
+             */
+            if (Reflected)
+            {
+                const uint64_t word = (loadLittleEndian64(data) ^ crc);
+
+                crc = static_cast<T>(TABLE[7][word & 0xFFU] ^ TABLE[6][(word >> 8U) & 0xFFU] ^ TABLE[5][(word >> 16U) & 0xFFU] ^ TABLE[4][(word >> 24U) & 0xFFU] ^
+                                     TABLE[3][(word >> 32U) & 0xFFU] ^ TABLE[2][(word >> 40U) & 0xFFU] ^ TABLE[1][(word >> 48U) & 0xFFU] ^ TABLE[0][word >> 56U]);
+            }
+            else
+            {
+                const uint64_t word = (loadBigEndian64(data) ^ (static_cast<uint64_t>(crc) << (64U - WIDTH)));
+
+                crc = static_cast<T>(TABLE[7][word >> 56U] ^ TABLE[6][(word >> 48U) & 0xFFU] ^ TABLE[5][(word >> 40U) & 0xFFU] ^ TABLE[4][(word >> 32U) & 0xFFU] ^
+                                     TABLE[3][(word >> 24U) & 0xFFU] ^ TABLE[2][(word >> 16U) & 0xFFU] ^ TABLE[1][(word >> 8U) & 0xFFU] ^ TABLE[0][word & 0xFFU]);
+            }
+        }
+
+        for (; size > 0U; --size)
+        {
+            crc = updateByte(TABLE, crc, *data++);
+        }
+
+        return crc;
+    }
+
+
+    using CRC8 = TableCRC<uint8_t, 0x07U, 0x00U, 0x00U, false>; // CRC-8/SMBUS.
+    using CRC16CCITT = TableCRC<uint16_t, 0x1021U, 0xFFFFU, 0x0000U, false>; // CRC-16/CCITT-FALSE.
+    using CRC32Table = TableCRC<uint32_t, 0xEDB88320U, 0xFFFFFFFFU, 0xFFFFFFFFU, true>; // CRC-32 (IEEE 802.3, zlib), portable implementation.
+    using CRC32CTable = TableCRC<uint32_t, 0x82F63B78U, 0xFFFFFFFFU, 0xFFFFFFFFU, true>; // CRC-32C (Castagnoli, iSCSI), portable implementation.
+
+
+    namespace kernels
+    {
+        uint32_t updateCRC32(const uint32_t crc, const uint8_t* data, const size_t size);
+        uint32_t updateCRC32C(const uint32_t crc, const uint8_t* data, const size_t size);
+    }
+
+
+    /*
+     * CRC-32 (IEEE 802.3, zlib), folded with PCLMULQDQ where the CPU supports it, otherwise CRC32Table.
+     */
+    struct CRC32 : CRC32Table
+    {
+        static constexpr size_t HARDWARE_MINIMUM_SIZE = 64U; // Below this the folding setup costs more than it saves, so the tables are used directly.
+
+        static ValueType
+        update(const ValueType crc, const uint8_t* data, const size_t size)
+        {
+            return ((size < HARDWARE_MINIMUM_SIZE) ? CRC32Table::update(crc, data, size) : kernels::updateCRC32(crc, data, size));
+        }
+    };
+
+
+    /*
+     * CRC-32C (Castagnoli, iSCSI), calculated with the SSE4.2 crc32 instruction where the CPU supports it, otherwise CRC32CTable.
+     */
+    struct CRC32C : CRC32CTable
+    {
+        static constexpr size_t HARDWARE_MINIMUM_SIZE = 16U; // Small updates, such as the stream decoders byte at a time updates, stay inline on the tables.
+
+        static ValueType
+        update(const ValueType crc, const uint8_t* data, const size_t size)
+        {
+            return ((size < HARDWARE_MINIMUM_SIZE) ? CRC32CTable::update(crc, data, size) : kernels::updateCRC32C(crc, data, size));
+        }
+    };
+}
@@ -0,0 +1,123 @@
+// Standard Libraries.
+#include <cstdlib>
+#include <cstring>
+
+// Application Libraries.
+#include "cobsDispatch.hpp"
+
+// CPU features are probed with GCC/Clang builtins.
+#if (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+    #define COBS_X86_DISPATCH
+#endif
+
+
+namespace
+{
+    constexpr const char* LEVEL_NAMES[] = {"scalar", "sse2", "ssse3", "sse4.2", "avx2"}; // Indexed by KernelLevel, also the COBS_KERNEL values.
+
+
+    /*
+     * Finds the highest level the CPU supports.
+     *
+     * @return  The level.
+     */
+    cobs::dispatch::KernelLevel
+    probeKernelLevel(void)
+    {
+        using cobs::dispatch::KernelLevel;
+
+#if defined(COBS_X86_DISPATCH)
+        __builtin_cpu_init();
+
+        if (!__builtin_cpu_supports("sse2"))
+        {
+            return KernelLevel::SCALAR;
+        }
+
+        if (!__builtin_cpu_supports("ssse3"))
+        {
+            return KernelLevel::SSE2;
+        }
+
+        if (!__builtin_cpu_supports("sse4.2"))
+        {
+            return KernelLevel::SSSE3;
+        }
+
+        if (!__builtin_cpu_supports("avx2"))
+        {
+            return KernelLevel::SSE42;
+        }
+
+        return KernelLevel::AVX2;
+#else
+        return KernelLevel::SCALAR;
+#endif
+    }
+
+
+    /*
+     * Probes the CPU and applies the COBS_KERNEL override.
+     *
+     * @return  The level every kernel is selected for.
+     */
+    cobs::dispatch::KernelLevel
+    selectKernelLevel(void)
+    {
+        const cobs::dispatch::KernelLevel supported = probeKernelLevel();
+        const char *requested = std::getenv("COBS_KERNEL");
+
+        if (requested != nullptr)
+        {
+            for (uint8_t level = 0U; level <= static_cast<uint8_t>(supported); ++level)
+            {
+                if (std::strcmp(requested, LEVEL_NAMES[level]) == 0)
+                {
+                    return static_cast<cobs::dispatch::KernelLevel>(level);
+                }
+            }
+        }
+
+        return supported;
+    }
+}
+
+
+/*
+ * @return  The instruction set level kernels are selected for, probed on the first call.
+ */
+cobs::dispatch::KernelLevel
+cobs::dispatch::getKernelLevel(void)
+{
+    static const KernelLevel level = selectKernelLevel(); // Initialised once, thread safe since C++11.
+
+    return level;
+}
+
+
+/*
+ * @param   level: Level to name.
+ *
+ * @return  Name of the level, as accepted by COBS_KERNEL.
+ */
+const char*
+cobs::dispatch::getKernelLevelName(const KernelLevel level)
+{
+    return LEVEL_NAMES[static_cast<uint8_t>(level)];
+}
+
+
+/*
+ * @return  True if the PCLMULQDQ (carry-less multiply) kernels may be used, which needs the CPU feature and at least KernelLevel::SSE42.
+ */
+bool
+cobs::dispatch::hasCarrylessMultiply(void)
+{
+#if defined(COBS_X86_DISPATCH)
+    static const bool supported = ((getKernelLevel() >= KernelLevel::SSE42) && __builtin_cpu_supports("pclmul"));
+
+    return supported;
+#else
+    return false;
+#endif
+}
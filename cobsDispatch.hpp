@@ -0,0 +1,32 @@
+#pragma once
+
+// Standard Libraries.
+#include <cstdint>
+
+
+/*
+ * Runtime CPU dispatch shared by every kernel in cobsKernels.cpp and cobsChecksum.cpp.
+ *
+ * The CPU is probed once, the first time any kernel is called, and every kernel then binds to its best variant for the resulting level.
+ * Setting the COBS_KERNEL environment variable to scalar, sse2, ssse3, sse4.2 or avx2 caps the level, e.g. to benchmark the scalar kernels
+ * on a machine with AVX2. It can only lower the level, it never enables instructions the CPU does not have. Unknown values are ignored.
+ */
+namespace cobs
+{
+    namespace dispatch
+    {
+        // Instruction set levels, each one includes every level below it.
+        enum class KernelLevel : uint8_t
+        {
+            SCALAR, // Portable C++, no intrinsics.
+            SSE2,
+            SSSE3,
+            SSE42, // SSE4.2, which brings the crc32 instruction used by CRC32C.
+            AVX2
+        };
+
+        KernelLevel getKernelLevel(void);
+        const char* getKernelLevelName(const KernelLevel level);
+        bool hasCarrylessMultiply(void);
+    }
+}
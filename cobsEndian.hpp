@@ -0,0 +1,40 @@
+#pragma once
+
+// Standard Libraries.
+#include <cstdint>
+
+
+/*
+ * Byte order helpers shared by the checksums and the codec kernels, which both read their input a 64 bit word at a time.
+ */
+namespace cobs
+{
+    /*
+     * Loads a little endian 64 bit word, compilers turn this into a single load (plus a byte swap on big endian machines).
+     *
+     * @param   data: First byte of the word.
+     *
+     * @return  The word.
+     */
+    inline uint64_t
+    loadLittleEndian64(const uint8_t* data)
+    {
+        return (static_cast<uint64_t>(data[0]) | (static_cast<uint64_t>(data[1]) << 8U) | (static_cast<uint64_t>(data[2]) << 16U) | (static_cast<uint64_t>(data[3]) << 24U) |
+                (static_cast<uint64_t>(data[4]) << 32U) | (static_cast<uint64_t>(data[5]) << 40U) | (static_cast<uint64_t>(data[6]) << 48U) | (static_cast<uint64_t>(data[7]) << 56U));
+    }
+
+
+    /*
+     * Loads a big endian 64 bit word.
+     *
+     * @param   data: First byte of the word.
+     *
+     * @return  The word.
+     */
+    inline uint64_t
+    loadBigEndian64(const uint8_t* data)
+    {
+        return ((static_cast<uint64_t>(data[0]) << 56U) | (static_cast<uint64_t>(data[1]) << 48U) | (static_cast<uint64_t>(data[2]) << 40U) | (static_cast<uint64_t>(data[3]) << 32U) |
+                (static_cast<uint64_t>(data[4]) << 24U) | (static_cast<uint64_t>(data[5]) << 16U) | (static_cast<uint64_t>(data[6]) << 8U) | static_cast<uint64_t>(data[7]));
+    }
+}
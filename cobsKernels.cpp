@@ -0,0 +1,408 @@
+// Standard Libraries.
+#include <atomic>
+#include <cstring>
+
+// Application Libraries.
+#include "cobsDispatch.hpp"
+#include "cobsEndian.hpp"
+#include "cobsKernels.hpp"
+
+// The vectorized kernels rely on GCC/Clang function multiversioning attributes and builtins.
+#if (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+    #define COBS_X86_KERNELS
+    #include <immintrin.h>
+#endif
+
+
+namespace
+{
+    using CopyUntilDelimiterKernel = size_t (*)(uint8_t*, const uint8_t*, const size_t, const uint8_t);
+    using FindDelimiterKernel = size_t (*)(const uint8_t*, const size_t, const uint8_t);
+
+    constexpr uint64_t SWAR_LOW_BITS = 0x0101010101010101ULL; // Lowest bit of every byte in a 64 bit word.
+    constexpr uint64_t SWAR_HIGH_BITS = 0x8080808080808080ULL; // Highest bit of every byte in a 64 bit word.
+
+
+    /*
+     * Flags the bytes of a little endian word which match a pattern, using the classic (x - 0x0101..) & ~x & 0x8080.. zero byte test
+     * on the word XORed with the pattern. Only the lowest flag is guaranteed exact, the borrow out of a match can also flag a 0x01 byte above it.
+     *
+     * @param   word: Eight bytes of data, first byte in the least significant position.
+     * @param   pattern: Byte value to find, repeated in every byte of the word.
+     *
+     * @return  Highest bit of each matching byte set, zero if there are none.
+     */
+    inline uint64_t
+    matchBytes(const uint64_t word, const uint64_t pattern)
+    {
+        const uint64_t difference = (word ^ pattern);
+
+        return ((difference - SWAR_LOW_BITS) & ~difference & SWAR_HIGH_BITS);
+    }
+
+
+    /*
+     * @param   matches: Non zero result of matchBytes().
+     *
+     * @return  Position of the first matching byte within the word.
+     */
+    inline size_t
+    firstMatch(uint64_t matches)
+    {
+#if defined(__GNUC__)
+        return (static_cast<size_t>(__builtin_ctzll(matches)) / 8U);
+#else
+        size_t position = 0U;
+
+        for (; (matches & 0x80U) == 0U; matches >>= 8U)
+        {
+            ++position;
+        }
+
+        return position;
+#endif
+    }
+
+
+    /*
+     * Copies bytes until the delimiter is found, eight at a time using SWAR (SIMD within a register) so no intrinsics are needed.
+     * Each word is loaded before it is stored, so an overlapping destination which starts before source is still copied correctly.
+     *
+     * @param   destination: Location to copy to, may overlap source provided it does not start after source.
+     * @param   source: Data to copy.
+     * @param   size: Maximum amount of bytes to copy.
+     * @param   delimiter: Byte value which stops the copy, it is not copied.
+     *
+     * @return  Total amount of bytes copied, equal to size if the delimiter was not found.
+     */
+    size_t
+    copyUntilDelimiterScalar(uint8_t* destination, const uint8_t* source, const size_t size, const uint8_t delimiter)
+    {
+        const uint64_t pattern = (SWAR_LOW_BITS * delimiter);
+        size_t i = 0U;
+
+        for (; (i + 8U) <= size; i += 8U)
+        {
+            const uint64_t matches = matchBytes(cobs::loadLittleEndian64(source + i), pattern);
+
+            if (matches != 0U)
+            {
+                const size_t runSize = firstMatch(matches);
+                std::memmove((destination + i), (source + i), runSize);
+                return (i + runSize);
+            }
+
+            uint64_t word;
+            std::memcpy(&word, (source + i), sizeof(word)); // Copied through a register, memcpy between the buffers would not allow them to overlap.
+            std::memcpy((destination + i), &word, sizeof(word));
+        }
+
+        for (; (i < size) && (source[i] != delimiter); ++i)
+        {
+            destination[i] = source[i];
+        }
+
+        return i;
+    }
+
+
+    /*
+     * Finds the delimiter with the C library memchr, which is the best portable search available.
+     *
+     * @param   data: Data to search.
+     * @param   size: Total number of bytes in data.
+     * @param   delimiter: Byte value to find.
+     *
+     * @return  Position of the first delimiter, equal to size if there is none.
+     */
+    size_t
+    findDelimiterScalar(const uint8_t* data, const size_t size, const uint8_t delimiter)
+    {
+        const uint8_t *position = static_cast<const uint8_t*>(std::memchr(data, delimiter, size));
+
+        return ((position != nullptr) ? static_cast<size_t>(position - data) : size);
+    }
+
+
+#if defined(COBS_X86_KERNELS)
+    /*
+     * SSE2 version of copyUntilDelimiterScalar(), compares 16 bytes at a time against the delimiter and stores whole chunks until one contains it.
+     * Each chunk is loaded before it is stored, so an overlapping destination which starts before source is still copied correctly.
+     */
+    __attribute__((target("sse2")))
+    size_t
+    copyUntilDelimiterSSE2(uint8_t* destination, const uint8_t* source, const size_t size, const uint8_t delimiter)
+    {
+        const __m128i pattern = _mm_set1_epi8(static_cast<char>(delimiter));
+        size_t i = 0U;
+
+        for (; (i + 16U) <= size; i += 16U)
+        {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+            const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern))); // One bit set for every byte equal to the delimiter.
+
+            if (mask != 0U)
+            {
+                const size_t runSize = static_cast<size_t>(__builtin_ctz(mask)); // Position of the first delimiter within this chunk.
+                std::memmove((destination + i), (source + i), runSize);
+                return (i + runSize);
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), chunk);
+        }
+
+        // Less than 16 bytes remain, finish them here rather than paying for another call.
+        for (; (i < size) && (source[i] != delimiter); ++i)
+        {
+            destination[i] = source[i];
+        }
+
+        return i;
+    }
+
+
+    /*
+     * AVX2 version of copyUntilDelimiterScalar(), compares 32 bytes at a time then finishes the remainder with one 16 byte chunk and a byte loop.
+     */
+    __attribute__((target("avx2")))
+    size_t
+    copyUntilDelimiterAVX2(uint8_t* destination, const uint8_t* source, const size_t size, const uint8_t delimiter)
+    {
+        const __m256i pattern = _mm256_set1_epi8(static_cast<char>(delimiter));
+        size_t i = 0U;
+
+        for (; (i + 32U) <= size; i += 32U)
+        {
+            const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+            const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, pattern)));
+
+            if (mask != 0U)
+            {
+                const size_t runSize = static_cast<size_t>(__builtin_ctz(mask));
+                std::memmove((destination + i), (source + i), runSize);
+                return (i + runSize);
+            }
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), chunk);
+        }
+
+        if ((i + 16U) <= size)
+        {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+            const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm256_castsi256_si128(pattern))));
+
+            if (mask != 0U)
+            {
+                const size_t runSize = static_cast<size_t>(__builtin_ctz(mask));
+                std::memmove((destination + i), (source + i), runSize);
+                return (i + runSize);
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), chunk);
+            i += 16U;
+        }
+
+        for (; (i < size) && (source[i] != delimiter); ++i)
+        {
+            destination[i] = source[i];
+        }
+
+        return i;
+    }
+
+
+    /*
+     * SSE2 version of findDelimiterScalar(), compares 16 bytes at a time.
+     */
+    __attribute__((target("sse2")))
+    size_t
+    findDelimiterSSE2(const uint8_t* data, const size_t size, const uint8_t delimiter)
+    {
+        const __m128i pattern = _mm_set1_epi8(static_cast<char>(delimiter));
+        size_t i = 0U;
+
+        for (; (i + 16U) <= size; i += 16U)
+        {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern)));
+
+            if (mask != 0U)
+            {
+                return (i + static_cast<size_t>(__builtin_ctz(mask)));
+            }
+        }
+
+        for (; (i < size) && (data[i] != delimiter); ++i)
+        {
+        }
+
+        return i;
+    }
+
+
+    /*
+     * AVX2 version of findDelimiterScalar(), compares 64 bytes per iteration as two 32 byte chunks then finishes the remainder with one
+     * 32 byte chunk and a byte loop.
+     */
+    __attribute__((target("avx2")))
+    size_t
+    findDelimiterAVX2(const uint8_t* data, const size_t size, const uint8_t delimiter)
+    {
+        const __m256i pattern = _mm256_set1_epi8(static_cast<char>(delimiter));
+        size_t i = 0U;
+
+        for (; (i + 64U) <= size; i += 64U)
+        {
+            const __m256i low = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), pattern);
+            const __m256i high = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32U)), pattern);
+
+            // Test both halves with one branch, the exact position is only worked out once a delimiter has been seen.
+            if (!_mm256_testz_si256(_mm256_or_si256(low, high), _mm256_or_si256(low, high)))
+            {
+                const uint64_t mask = (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(low))) |
+                                       (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(high))) << 32U));
+
+                return (i + static_cast<size_t>(__builtin_ctzll(mask)));
+            }
+        }
+
+        if ((i + 32U) <= size)
+        {
+            const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), pattern)));
+
+            if (mask != 0U)
+            {
+                return (i + static_cast<size_t>(__builtin_ctz(mask)));
+            }
+
+            i += 32U;
+        }
+
+        for (; (i < size) && (data[i] != delimiter); ++i)
+        {
+        }
+
+        return i;
+    }
+#endif
+
+
+    /*
+     * Picks the fastest copyUntilDelimiter kernel for the dispatch level, see cobsDispatch.hpp.
+     * Nothing here gains from SSSE3 or SSE4.2, so those levels use the SSE2 kernel.
+     *
+     * @return  The selected kernel.
+     */
+    CopyUntilDelimiterKernel
+    selectCopyUntilDelimiter(void)
+    {
+#if defined(COBS_X86_KERNELS)
+        const cobs::dispatch::KernelLevel level = cobs::dispatch::getKernelLevel();
+
+        if (level >= cobs::dispatch::KernelLevel::AVX2)
+        {
+            return copyUntilDelimiterAVX2;
+        }
+
+        if (level >= cobs::dispatch::KernelLevel::SSE2)
+        {
+            return copyUntilDelimiterSSE2;
+        }
+#endif
+
+        return copyUntilDelimiterScalar;
+    }
+
+
+    /*
+     * Picks the fastest findDelimiter kernel for the dispatch level, see cobsDispatch.hpp.
+     *
+     * @return  The selected kernel.
+     */
+    FindDelimiterKernel
+    selectFindDelimiter(void)
+    {
+#if defined(COBS_X86_KERNELS)
+        const cobs::dispatch::KernelLevel level = cobs::dispatch::getKernelLevel();
+
+        if (level >= cobs::dispatch::KernelLevel::AVX2)
+        {
+            return findDelimiterAVX2;
+        }
+
+        if (level >= cobs::dispatch::KernelLevel::SSE2)
+        {
+            return findDelimiterSSE2;
+        }
+#endif
+
+        return findDelimiterScalar;
+    }
+
+
+    size_t copyUntilDelimiterResolve(uint8_t* destination, const uint8_t* source, const size_t size, const uint8_t delimiter);
+
+    /*
+     * Starts out pointing at the resolver, which replaces it with the selected kernel on first use.
+     * This is constant initialised, so it is safe to use from other static initialisers, and atomic so concurrent first calls are safe.
+     */
+    std::atomic<CopyUntilDelimiterKernel> copyUntilDelimiterKernel(copyUntilDelimiterResolve);
+
+
+    size_t
+    copyUntilDelimiterResolve(uint8_t* destination, const uint8_t* source, const size_t size, const uint8_t delimiter)
+    {
+        const CopyUntilDelimiterKernel kernel = selectCopyUntilDelimiter();
+        copyUntilDelimiterKernel.store(kernel, std::memory_order_relaxed);
+
+        return kernel(destination, source, size, delimiter);
+    }
+
+
+    size_t findDelimiterResolve(const uint8_t* data, const size_t size, const uint8_t delimiter);
+
+    std::atomic<FindDelimiterKernel> findDelimiterKernel(findDelimiterResolve); // See copyUntilDelimiterKernel.
+
+
+    size_t
+    findDelimiterResolve(const uint8_t* data, const size_t size, const uint8_t delimiter)
+    {
+        const FindDelimiterKernel kernel = selectFindDelimiter();
+        findDelimiterKernel.store(kernel, std::memory_order_relaxed);
+
+        return kernel(data, size, delimiter);
+    }
+}
+
+
+/*
+ * Copies bytes from source to destination until the delimiter is found or size bytes have been copied.
+ *
+ * @param   destination: Location to copy to, may overlap source provided it does not start after source.
+ * @param   source: Data to copy.
+ * @param   size: Maximum amount of bytes to copy.
+ * @param   delimiter: Byte value which stops the copy, it is not copied.
+ *
+ * @return  Total amount of bytes copied, equal to size if the delimiter was not found.
+ */
+size_t
+cobs::kernels::copyUntilDelimiter(uint8_t* destination, const uint8_t* source, const size_t size, const uint8_t delimiter)
+{
+    return copyUntilDelimiterKernel.load(std::memory_order_relaxed)(destination, source, size, delimiter);
+}
+
+
+/*
+ * Finds the first delimiter in data.
+ *
+ * @param   data: Data to search.
+ * @param   size: Total number of bytes in data.
+ * @param   delimiter: Byte value to find.
+ *
+ * @return  Position of the first delimiter, equal to size if there is none.
+ */
+size_t
+cobs::kernels::findDelimiter(const uint8_t* data, const size_t size, const uint8_t delimiter)
+{
+    return findDelimiterKernel.load(std::memory_order_relaxed)(data, size, delimiter);
+}
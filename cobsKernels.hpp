@@ -0,0 +1,26 @@
+#pragma once
+
+// Standard Libraries.
+#include <cstddef>
+#include <cstdint>
+
+
+/*
+ * Low level byte kernels used by the COBS encoder and decoder.
+ *
+ * Each kernel has a scalar implementation and, where the CPU supports it, vectorized implementations.
+ * The best implementation is chosen at runtime the first time a kernel is called, see cobsDispatch.hpp.
+ *
+ * copyUntilDelimiter() is given overlapping buffers by encodeInPlace(), with the destination starting before the source. Every
+ * implementation must therefore copy strictly forwards: load each chunk before storing it, and never store past the bytes copied so far.
+ * The usual SIMD tail trick of one last overlapping store of the final 16 or 32 bytes breaks this, it overwrites source bytes which have
+ * not been read yet and silently corrupts the frame. ./cobsBenchmark --self-test checks encodeInPlace() against encodeMessage().
+ */
+namespace cobs
+{
+    namespace kernels
+    {
+        size_t copyUntilDelimiter(uint8_t* destination, const uint8_t* source, const size_t size, const uint8_t delimiter);
+        size_t findDelimiter(const uint8_t* data, const size_t size, const uint8_t delimiter);
+    }
+}
@@ -1,27 +1,1325 @@
 #pragma once
 
 // Standard Libraries.
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#if (__cplusplus >= 202002L)
+#include <span>
+#endif
+#include <utility>
+#ifndef COBS_NO_HEAP
 #include <vector>
+#endif
 
+// System Libraries.
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#endif
 
-class COBSParser
+// Application Libraries.
+#include "cobsChecksum.hpp"
+#include "cobsKernels.hpp"
+#include "cobsStorage.hpp"
+
+
+// Result of decoding a frame into a caller supplied buffer.
+enum class COBSStatus : uint8_t
+{
+    OK, // Frame decoded and validated.
+    INVALID_FRAME, // Frame is malformed, e.g. it is too short to contain a CRC.
+    CRC_MISMATCH, // Frame decoded but the received CRC does not match the calculated CRC.
+    OUTPUT_TOO_SMALL, // Output buffer cannot hold the decoded frame.
+    FRAME_TOO_LARGE // Frame decodes to more than MAX_FRAME_SIZE bytes of message, decoding stopped as soon as the limit was passed.
+};
+
+
+// A contiguous piece of data to encode, e.g. one message of a batch.
+struct COBSSegment
+{
+    const uint8_t* data; // First byte of the data.
+    uint32_t size; // Total number of bytes in data.
+};
+
+
+#if __has_include(<sys/uio.h>)
+// A piece of an encoded frame produced by encodeToSegments(), an array of them is passed straight to writev().
+using COBSIOVec = struct iovec;
+#else
+// A piece of an encoded frame produced by encodeToSegments(), laid out like the POSIX struct iovec for platforms without one.
+struct COBSIOVec
+{
+    void* iov_base; // First byte of the data.
+    size_t iov_len; // Total number of bytes in data.
+};
+#endif
+
+
+// Counters kept by the batch and stream decoders for frames dropped because they went over MAX_FRAME_SIZE.
+struct COBSResyncStats
 {
+    uint32_t resyncCount; // Number of times decoding skipped forward to the next DELIMITER to resynchronise.
+    uint32_t lastDiscardedBytes; // Encoded bytes dropped by the most recent completed resync, including the DELIMITER it resynchronised on.
+    uint64_t totalDiscardedBytes; // Encoded bytes dropped across every completed resync.
+};
+
+
+// Entry in the frame table produced by decodeBatch(), locates one decoded message within the batch output arena.
+struct COBSFrame
+{
+    uint32_t offset; // Offset of the decoded message in the arena.
+    uint32_t size; // Total amount of bytes in the decoded message, zero unless status is COBSStatus::OK.
+    COBSStatus status; // Result of decoding this frame.
+};
+
+
+/*
+ * COBS encoder/decoder, each frame carries a CRC of the message which is validated when decoding.
+ *
+ * Everything is fixed at compile time so each link type gets its own fully inlined codec, e.g. BasicCOBSCodec<64U> for short control frames
+ * or BasicCOBSCodec<65536U, 0x00U, cobs::CRC32C> for bulk transfers.
+ *
+ * @tparam  MaxFrame: Largest message accepted by the decoders, anything larger is treated as a syncing issue.
+ * @tparam  Delimiter: Byte which ends each frame. Overhead bytes are XORed with it, so for any value other than ASCII_NULL the run of data
+ *                     bytes between delimiters in the message is still copied through untouched.
+ * @tparam  ChecksumPolicy: Checksum used as the CRC, see cobsChecksum.hpp. XOR keeps the original single byte checksum, CRC8, CRC16CCITT,
+ *                          CRC32 and CRC32C trade a few more bytes per frame for much stronger error detection.
+ * @tparam  StoragePolicy: Holds the message decoded by decodeMessage(), see cobsStorage.hpp.
+ */
+template <uint32_t MaxFrame = 1024U, uint8_t Delimiter = 0x00U, typename ChecksumPolicy = cobs::XORChecksum, typename StoragePolicy = cobs::DefaultStorage>
+class BasicCOBSCodec
+{
+    static_assert(MaxFrame > 0U, "A codec must accept at least a one byte message.");
+
     public:
-        COBSParser(){}
+        BasicCOBSCodec(){}
+
+        using CRCType = typename ChecksumPolicy::ValueType;
+        using ChecksumPolicyType = ChecksumPolicy;
+        using MessageType = typename StoragePolicy::template Buffer<(MaxFrame + ChecksumPolicy::SIZE)>::MessageType; // Returned by takeMessage(), std::vector<uint8_t> for VectorStorage.
 
         static constexpr uint8_t ASCII_NULL = 0x00U;
-        static constexpr uint32_t MAX_FRAME_SIZE = 1024U; // Need to put a limit on the frame size to identify syncing issues.
+        static constexpr uint8_t DELIMITER = Delimiter; // Ends every frame and never appears anywhere else in an encoded frame.
+        static constexpr uint32_t MAX_FRAME_SIZE = MaxFrame; // Need to put a limit on the frame size to identify syncing issues.
+        static constexpr uint32_t CRC_SIZE = ChecksumPolicy::SIZE; // Number of CRC bytes which trail the message in every frame.
 
-        uint32_t encodeMessage(const uint8_t* input, const uint32_t inputSize, std::vector<uint8_t>& output);
+        // Worst case number of overhead bytes for an input of inputSize bytes. This is the first blocks overhead byte plus an overhead byte for every 254 bytes of input and CRC.
+        static constexpr uint32_t maxOverheadSize(const uint32_t inputSize) { return (((inputSize + CRC_SIZE) / 254U) + 1U); }
+
+        // Worst case number of encoded bytes for an input of inputSize bytes. This is the input, the CRC bytes, the overhead bytes and the DELIMITER byte to signal end of frame.
+        static constexpr uint32_t maxEncodedSize(const uint32_t inputSize) { return ((inputSize + CRC_SIZE) + maxOverheadSize(inputSize) + 1U); }
+
+        static constexpr uint32_t MAX_ENCODED_FRAME_SIZE = maxEncodedSize(MAX_FRAME_SIZE); // Largest valid frame including its DELIMITER, a frame which has not ended by then is a syncing issue.
+        static constexpr uint32_t ENCODE_HEADROOM = maxOverheadSize(MAX_FRAME_SIZE); // Space reserved in front of the payload for encodeInPlace().
+        static constexpr uint32_t MIN_SEGMENT_RUN_SIZE = 32U; // encodeToSegments() copies delimiter free runs shorter than this into scratch, an extra iovec entry costs more than the copy.
+
+        // Static methods hold no state, so they can be called from any number of threads at once without a parser, see also cobs::encode() and cobs::decode().
+        static uint32_t encodeMessage(const uint8_t* input, const uint32_t inputSize, uint8_t* output, const uint32_t outputSize);
+        static uint32_t encodeGather(const COBSSegment* segments, const uint32_t segmentCount, uint8_t* output, const uint32_t outputSize);
+        static uint32_t encodeToSegments(const uint8_t* input, const uint32_t inputSize, COBSIOVec* segments, const uint32_t maxSegments, uint8_t* scratch, const uint32_t scratchSize, uint32_t& segmentCount);
+        static uint32_t encodeInPlace(uint8_t* buffer, const uint32_t bufferSize, const uint32_t payloadSize);
+        static uint32_t encodeBatch(const COBSSegment* messages, const uint32_t messageCount, uint8_t* output, const uint32_t outputSize, uint32_t* offsets);
+        static COBSStatus decodeMessage(const uint8_t* input, const uint32_t inputSize, uint8_t* output, const uint32_t outputSize, uint32_t& messageSize);
+        static COBSStatus decodeInPlace(uint8_t* frame, const uint32_t frameSize, COBSSegment& message);
+        bool decodeMessage(const uint8_t* input, const uint32_t inputSize);
+#ifndef COBS_NO_HEAP
+        // Convenience overloads which size std::vector outputs for the caller, left out of allocation free builds.
+        static uint32_t encodeMessage(const uint8_t* input, const uint32_t inputSize, std::vector<uint8_t>& output);
+        static uint32_t encodeGather(const COBSSegment* segments, const uint32_t segmentCount, std::vector<uint8_t>& output);
+        static uint32_t encodeToSegments(const uint8_t* input, const uint32_t inputSize, std::vector<COBSIOVec>& segments, std::vector<uint8_t>& scratch);
+        static uint32_t encodeBatch(const COBSSegment* messages, const uint32_t messageCount, std::vector<uint8_t>& output, std::vector<uint32_t>& offsets);
         bool decodeMessage(const std::vector<uint8_t>& output);
+        uint32_t decodeBatch(const uint8_t* input, const uint32_t inputSize, std::vector<uint8_t>& arena, std::vector<COBSFrame>& frames);
+#endif // COBS_NO_HEAP
         const uint8_t* getMessage(void) const { return m_message.data(); }
+        uint32_t getMessageSize(void) const { return m_message.size(); }
+#if (__cplusplus >= 202002L)
+        std::span<const uint8_t> getMessageSpan(void) const { return {m_message.data(), m_message.size()}; }
+#endif
+        MessageType takeMessage(void);
+        void recycleMessage(MessageType&& message);
+        const COBSResyncStats& getResyncStats(void) const { return m_resyncStats; }
 
     private:
+        template <typename>
+        friend class BasicCOBSStreamDecoder;
+
         static constexpr uint8_t MAX_BLOCK_SIZE = 0xFFU;
+        static constexpr uint32_t INLINE_RUN_SIZE = 16U; // Runs shorter than this are copied inline rather than by a kernel or library call.
+        static constexpr uint32_t CRC_SPAN_SIZE = 1024U; // Bytes added to the CRC per update while encoding and decoding. Each span is read twice, once for the CRC and once to copy it, and this keeps the second read in L1 cache.
 
-        std::vector<uint8_t> m_message;
+        typename StoragePolicy::template Buffer<(MaxFrame + ChecksumPolicy::SIZE)> m_message; // Sized for the CRC too, as the whole frame is decoded into it.
+        COBSResyncStats m_resyncStats = {}; // Resyncs made by decodeBatch().
+        uint32_t m_resyncSize = 0U; // Encoded bytes dropped so far by the resync in progress.
+        bool m_resyncing = false; // Set while decodeBatch() is skipping an oversized frame which continues past the end of its input.
 
-        uint8_t calculateCRC(const uint8_t* const data, const uint32_t size);
+        static void encodeBlocks(const uint8_t* input, uint32_t inputSize, uint8_t*& encodedMessage, uint8_t*& overheadByte, uint8_t& overheadCount, CRCType* crc);
+#ifndef COBS_NO_HEAP
+        uint32_t decodeBatchFrame(const uint8_t* frame, const uint32_t frameSize, std::vector<uint8_t>& arena, uint32_t& arenaSize, std::vector<COBSFrame>& frames);
+#endif // COBS_NO_HEAP
 };
+
+
+/*
+ * Incremental decoder for a continuous COBS byte stream (e.g. a serial port).
+ *
+ * Bytes are decoded as they arrive, so frames never have to be buffered and split on the delimiter by the caller.
+ * Each byte costs O(1) and the decoded frame lives in a fixed size buffer, so no heap allocation is ever made.
+ *
+ * @tparam  Codec: BasicCOBSCodec the stream was encoded with, its frame size, delimiter and checksum are used.
+ */
+template <typename Codec>
+class BasicCOBSStreamDecoder
+{
+    public:
+        BasicCOBSStreamDecoder(){}
+
+        bool decodeByte(const uint8_t byte);
+        template <typename Callback>
+        uint32_t decode(const uint8_t* input, const uint32_t inputSize, Callback&& onMessage);
+        void reset(void);
+        const uint8_t* getMessage(void) const { return m_buffer.data(); }
+        uint32_t getMessageSize(void) const { return m_messageSize; }
+#if (__cplusplus >= 202002L)
+        std::span<const uint8_t> getMessageSpan(void) const { return {m_buffer.data(), m_messageSize}; }
+#endif
+        const COBSResyncStats& getResyncStats(void) const { return m_resyncStats; }
+
+    private:
+        using Parser = Codec;
+        using ChecksumPolicy = typename Codec::ChecksumPolicyType;
+
+        std::array<uint8_t, (Parser::MAX_FRAME_SIZE + Parser::CRC_SIZE)> m_buffer; // Decoded frame, the CRC bytes trail the message.
+        uint32_t m_frameSize = 0U; // Number of bytes decoded so far in the current frame.
+        uint32_t m_encodedSize = 0U; // Number of encoded bytes received so far in the current frame.
+        uint32_t m_messageSize = 0U; // Size of the last validated message.
+        uint8_t m_blockSize = 0U; // Number of data bytes remaining in the current block, zero when the next byte is an overhead byte.
+        uint8_t m_overheadCount = Parser::MAX_BLOCK_SIZE; // Overhead byte of the previous block, MAX_BLOCK_SIZE so no DELIMITER is inserted before the first block.
+        typename Parser::CRCType m_crc = ChecksumPolicy::begin(); // Running CRC of the decoded bytes, trailing CRC_SIZE bytes behind so it never includes the received CRC.
+        bool m_discarding = false; // Set when the current frame is invalid, all bytes are then ignored until the next DELIMITER.
+        COBSResyncStats m_resyncStats = {}; // Frames dropped for going over MAX_FRAME_SIZE.
+};
+
+
+// The original parser, ASCII_NULL delimited frames of up to 1024 bytes, with a choice of checksum.
+template <typename ChecksumPolicy = cobs::XORChecksum>
+using BasicCOBSParser = BasicCOBSCodec<1024U, 0x00U, ChecksumPolicy, cobs::DefaultStorage>;
+
+using COBSParser = BasicCOBSParser<>;
+using COBSStreamDecoder = BasicCOBSStreamDecoder<COBSParser>;
+
+// The default parser is compiled once in cobsParser.cpp rather than in every file which uses it.
+extern template class BasicCOBSCodec<1024U, 0x00U, cobs::XORChecksum, cobs::DefaultStorage>;
+extern template class BasicCOBSStreamDecoder<COBSParser>;
+
+
+/*
+ * Stateless interface to the codecs. Nothing is shared between calls, so any number of threads can encode and decode concurrently
+ * with no synchronisation and no parser per thread.
+ */
+namespace cobs
+{
+    /*
+     * Encodes input data into a caller supplied buffer, see BasicCOBSCodec::encodeMessage().
+     *
+     * @tparam  Codec: BasicCOBSCodec configuration to encode with.
+     * @param   input: Data to encode.
+     * @param   inputSize: Total number of bytes in data.
+     * @param   output: Location to store the encoded message.
+     * @param   outputSize: Total number of bytes available in output, Codec::maxEncodedSize(inputSize) is always enough.
+     *
+     * @return  Total amount of encoded bytes, zero if output is too small.
+     */
+    template <typename Codec = COBSParser>
+    inline uint32_t
+    encode(const uint8_t* input, const uint32_t inputSize, uint8_t* output, const uint32_t outputSize)
+    {
+        return Codec::encodeMessage(input, inputSize, output, outputSize);
+    }
+
+
+    /*
+     * Decodes a frame into a caller supplied buffer, see BasicCOBSCodec::decodeMessage().
+     *
+     * @tparam  Codec: BasicCOBSCodec configuration to decode with.
+     * @param   input: Data to decode.
+     * @param   inputSize: Total number of bytes in data.
+     * @param   output: Location to store the decoded message followed by its CRC bytes, inputSize bytes is always enough.
+     * @param   outputSize: Total number of bytes available in output.
+     * @param   messageSize: Total amount of bytes in the decoded message, only updated when the message is validated.
+     *
+     * @return  COBSStatus::OK if decoded message is validated, else the reason it was rejected.
+     */
+    template <typename Codec = COBSParser>
+    inline COBSStatus
+    decode(const uint8_t* input, const uint32_t inputSize, uint8_t* output, const uint32_t outputSize, uint32_t& messageSize)
+    {
+        return Codec::decodeMessage(input, inputSize, output, outputSize, messageSize);
+    }
+
+
+#ifndef COBS_NO_HEAP
+    /*
+     * Encodes input data into a vector, which is resized to the encoded frame.
+     *
+     * @tparam  Codec: BasicCOBSCodec configuration to encode with.
+     * @param   input: Data to encode.
+     * @param   inputSize: Total number of bytes in data.
+     * @param   output: Location to store the encoded message.
+     *
+     * @return  Total amount of encoded bytes.
+     */
+    template <typename Codec = COBSParser>
+    inline uint32_t
+    encode(const uint8_t* input, const uint32_t inputSize, std::vector<uint8_t>& output)
+    {
+        return Codec::encodeMessage(input, inputSize, output);
+    }
+
+
+    /*
+     * Decodes a frame into a vector, which is resized to the decoded message.
+     *
+     * @tparam  Codec: BasicCOBSCodec configuration to decode with.
+     * @param   input: Data to decode.
+     * @param   inputSize: Total number of bytes in data.
+     * @param   message: Location to store the decoded message, its contents are undefined if decoding fails.
+     *
+     * @return  COBSStatus::OK if decoded message is validated, else the reason it was rejected.
+     */
+    template <typename Codec = COBSParser>
+    inline COBSStatus
+    decode(const uint8_t* input, const uint32_t inputSize, std::vector<uint8_t>& message)
+    {
+        const uint32_t maxDecodedSize = (Codec::MAX_FRAME_SIZE + Codec::CRC_SIZE); // Anything larger is rejected with COBSStatus::FRAME_TOO_LARGE.
+        uint32_t messageSize = 0U;
+
+        message.resize((inputSize < maxDecodedSize) ? inputSize : maxDecodedSize);
+
+        const COBSStatus status = Codec::decodeMessage(input, inputSize, message.data(), static_cast<uint32_t>(message.size()), messageSize);
+
+        message.resize((status == COBSStatus::OK) ? messageSize : 0U);
+
+        return status;
+    }
+#endif // COBS_NO_HEAP
+}
+
+
+#ifndef COBS_NO_HEAP
+/*
+ * Encodes input data using COBS encoding.
+ *
+ * @param   input: Data to encode.
+ * @param   inputSize: Total number of bytes in data.
+ * @param   output: Location to store encoded data.
+ *
+ * @return  Total amount of encoded bytes.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+uint32_t
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::encodeMessage(const uint8_t* input, const uint32_t inputSize, std::vector<uint8_t>& output)
+{
+    // Resize output buffer to the expected length. Once the vector has grown to this size no further allocations are made when it is reused.
+    output.resize(maxEncodedSize(inputSize));
+
+    const uint32_t actualLen = encodeMessage(input, inputSize, output.data(), static_cast<uint32_t>(output.size()));
+
+    /*
+     * Resize again, this is because I expect the resize to shrink the vector, if it was to expand, performance would be impacted
+     * because the vector would need to allocate new memory and copy across the existing data and therefore, this is why the worst case length is used in the first resize.
+     */
+    output.resize(actualLen);
+
+    return actualLen;
+}
+#endif // COBS_NO_HEAP
+
+
+/*
+ * Encodes input data using COBS encoding into a caller supplied buffer, no heap allocation is made.
+ *
+ * @param   input: Data to encode.
+ * @param   inputSize: Total number of bytes in data.
+ * @param   output: Location to store encoded data. May overlap input provided it starts at least maxOverheadSize(inputSize) bytes before it, see encodeInPlace().
+ * @param   outputSize: Total number of bytes available in output, must be at least maxEncodedSize(inputSize).
+ *
+ * @return  Total amount of encoded bytes, zero if the output buffer is too small.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+uint32_t
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::encodeMessage(const uint8_t* input, const uint32_t inputSize, uint8_t* output, const uint32_t outputSize)
+{
+    const COBSSegment segment = {input, inputSize};
+
+    return encodeGather(&segment, 1U, output, outputSize);
+}
+
+
+#ifndef COBS_NO_HEAP
+/*
+ * Encodes a message made up of several segments, e.g. a header, a payload held elsewhere and a trailer, without concatenating them first.
+ *
+ * @param   segments: Segments of the message, in order.
+ * @param   segmentCount: Total number of segments.
+ * @param   output: Location to store encoded data.
+ *
+ * @return  Total amount of encoded bytes.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+uint32_t
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::encodeGather(const COBSSegment* segments, const uint32_t segmentCount, std::vector<uint8_t>& output)
+{
+    uint32_t inputSize = 0U;
+
+    for (uint32_t i = 0U; i < segmentCount; ++i)
+    {
+        inputSize += segments[i].size;
+    }
+
+    // As with encodeMessage(), resize to the worst case length first and shrink to the actual length afterwards.
+    output.resize(maxEncodedSize(inputSize));
+
+    const uint32_t actualLen = encodeGather(segments, segmentCount, output.data(), static_cast<uint32_t>(output.size()));
+
+    output.resize(actualLen);
+
+    return actualLen;
+}
+#endif // COBS_NO_HEAP
+
+
+/*
+ * Encodes a message made up of several segments into a caller supplied buffer, no heap allocation is made.
+ *
+ * @param   segments: Segments of the message, in order.
+ * @param   segmentCount: Total number of segments.
+ * @param   output: Location to store encoded data.
+ * @param   outputSize: Total number of bytes available in output, must be at least maxEncodedSize() of the combined segment sizes.
+ *
+ * @return  Total amount of encoded bytes, zero if the output buffer is too small.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+uint32_t
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::encodeGather(const COBSSegment* segments, const uint32_t segmentCount, uint8_t* output, const uint32_t outputSize)
+{
+    uint32_t inputSize = 0U;
+
+    for (uint32_t i = 0U; i < segmentCount; ++i)
+    {
+        inputSize += segments[i].size;
+    }
+
+    // An encoded frame is never empty, so zero is free to signal the output buffer cannot hold the worst case encoding.
+    if (outputSize < maxEncodedSize(inputSize))
+    {
+        return 0U;
+    }
+
+    // Encode data.
+    uint8_t *encodedMessage = output; // Pointer to the output buffer which we will be writing the encoded message to. Pointing at output[0].
+    uint8_t *overheadByte = encodedMessage++; // The overhead byte will always be at the first position of a block, here we assign it to output[0] and increment the encoded message pointer to output[1] in preparation for data to be inserted.
+    uint8_t overheadCount = 0x01; // A new block is about to start, at a minimum there is always 1 byte in a block, hence its count is set to 1 here.
+
+    CRCType crc = ChecksumPolicy::begin();
+
+    // Encode each segment in turn. The block state and CRC carry on from one segment to the next, so the segments encode exactly as if they were contiguous.
+    for (uint32_t i = 0U; i < segmentCount; ++i)
+    {
+        encodeBlocks(segments[i].data, segments[i].size, encodedMessage, overheadByte, overheadCount, &crc); // The CRC is calculated span by span as the input is encoded, so the second read of each span is from L1 cache.
+    }
+
+    uint8_t crcBytes[CRC_SIZE];
+    cobs::storeChecksum(ChecksumPolicy::end(crc), crcBytes);
+    encodeBlocks(crcBytes, CRC_SIZE, encodedMessage, overheadByte, overheadCount, nullptr); // Then add the CRC for encoding to complete the encoded message.
+
+    *overheadByte = static_cast<uint8_t>(overheadCount ^ DELIMITER); // Update the overhead count for the final block.
+    *encodedMessage++ = DELIMITER; // Finally, append the DELIMITER signalling end of frame.
+
+    return static_cast<uint32_t>(encodedMessage - output); // Calculate the total number of encoded bytes = encodedMessage[x] - output[0].
+}
+
+
+#ifndef COBS_NO_HEAP
+/*
+ * Encodes input data as a list of segments for writev(), so the encoded frame is never copied together in user space.
+ *
+ * @param   input: Data to encode, the segments point into it so it must outlive them.
+ * @param   inputSize: Total number of bytes in data.
+ * @param   segments: Filled with the segments of the encoded frame, in order.
+ * @param   scratch: Holds the generated bytes the segments point to. Only ever grown, so no allocation is made once it has reached its steady state size.
+ *
+ * @return  Total amount of encoded bytes across all segments.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+uint32_t
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::encodeToSegments(const uint8_t* input, const uint32_t inputSize, std::vector<COBSIOVec>& segments, std::vector<uint8_t>& scratch)
+{
+    /*
+     * Generated and copied bytes can never outnumber the bytes of the encoded frame. Each input run segment holds at least MIN_SEGMENT_RUN_SIZE bytes
+     * and is followed by at most one scratch segment, which bounds the number of segments.
+     */
+    const uint32_t maxScratchSize = maxEncodedSize(inputSize);
+    const uint32_t maxSegments = (((inputSize / MIN_SEGMENT_RUN_SIZE) * 2U) + 1U);
+
+    if (scratch.size() < maxScratchSize)
+    {
+        scratch.resize(maxScratchSize);
+    }
+
+    segments.resize(maxSegments);
+
+    uint32_t segmentCount = 0U;
+    const uint32_t encodedSize = encodeToSegments(input, inputSize, segments.data(), maxSegments, scratch.data(), static_cast<uint32_t>(scratch.size()), segmentCount);
+
+    segments.resize(segmentCount);
+
+    return encodedSize;
+}
+#endif // COBS_NO_HEAP
+
+
+/*
+ * Encodes input data as a list of segments for writev(), using caller supplied storage so no heap allocation is made.
+ *
+ * The segments alternate between small runs of generated bytes held in scratch (overhead bytes, the CRC and the DELIMITER signalling end of frame)
+ * and pointers straight into the delimiter free runs of input, so a large payload with few DELIMITER bytes costs only a handful of generated bytes.
+ * The segments are struct iovec entries, so they go straight to writev(segments, segmentCount). writev() never writes through iov_base,
+ * which is the only reason input loses its const in them.
+ *
+ * @param   input: Data to encode, the segments point into it so it must outlive them.
+ * @param   inputSize: Total number of bytes in data.
+ * @param   segments: Location to store the segments of the encoded frame.
+ * @param   maxSegments: Total number of segments available, (inputSize / MIN_SEGMENT_RUN_SIZE) * 2 + 1 is always enough.
+ * @param   scratch: Location to store generated bytes.
+ * @param   scratchSize: Total number of bytes available in scratch, maxEncodedSize(inputSize) is always enough.
+ * @param   segmentCount: Total number of segments used, only updated on success.
+ *
+ * @return  Total amount of encoded bytes across all segments, zero if segments or scratch ran out of space.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+uint32_t
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::encodeToSegments(const uint8_t* input, const uint32_t inputSize, COBSIOVec* segments, const uint32_t maxSegments, uint8_t* scratch, const uint32_t scratchSize, uint32_t& segmentCount)
+{
+    uint32_t segmentsUsed = 0U;
+    uint32_t scratchUsed = 0U;
+    uint32_t encodedSize = 0U;
+
+    // Appends bytes to scratch, growing the last segment when it ends where these bytes start so consecutive generated bytes share a segment.
+    auto addScratch = [&](const uint8_t* data, const uint32_t size) -> uint8_t*
+    {
+        if ((scratchSize - scratchUsed) < size)
+        {
+            return nullptr;
+        }
+
+        uint8_t *position = (scratch + scratchUsed);
+        std::memcpy(position, data, size);
+        scratchUsed += size;
+        encodedSize += size;
+
+        if ((segmentsUsed > 0U) && ((static_cast<uint8_t*>(segments[segmentsUsed - 1U].iov_base) + segments[segmentsUsed - 1U].iov_len) == position))
+        {
+            segments[segmentsUsed - 1U].iov_len += size;
+        }
+        else if (segmentsUsed < maxSegments)
+        {
+            segments[segmentsUsed].iov_base = position;
+            segments[segmentsUsed++].iov_len = size;
+        }
+        else
+        {
+            return nullptr;
+        }
+
+        return position;
+    };
+
+    CRCType crc = ChecksumPolicy::begin();
+    uint8_t overheadCount = 0x01; // A new block is about to start, at a minimum there is always 1 byte in a block.
+    uint8_t *overheadByte = addScratch(&DELIMITER, 1U); // Placeholder for the first overhead byte, filled in when the block is terminated.
+
+    if (overheadByte == nullptr)
+    {
+        return 0U;
+    }
+
+    const uint8_t *data = input;
+    uint32_t remaining = inputSize;
+
+    // Encode data. This follows encodeBlocks(), but the delimiter free runs are referenced rather than copied.
+    while (remaining > 0U)
+    {
+        const uint32_t blockSpace = (MAX_BLOCK_SIZE - overheadCount);
+        const uint32_t runLimit = ((remaining < blockSpace) ? remaining : blockSpace);
+        const uint32_t runSize = static_cast<uint32_t>(cobs::kernels::findDelimiter(data, runLimit, DELIMITER));
+        const bool foundNull = (runSize != runLimit);
+
+        crc = ChecksumPolicy::update(crc, data, (runSize + (foundNull ? 1U : 0U))); // The DELIMITER which ends the run is part of the CRC.
+
+        if (runSize >= MIN_SEGMENT_RUN_SIZE)
+        {
+            if (segmentsUsed == maxSegments)
+            {
+                return 0U;
+            }
+
+            segments[segmentsUsed].iov_base = const_cast<uint8_t*>(data);
+            segments[segmentsUsed++].iov_len = runSize;
+            encodedSize += runSize;
+        }
+        else if ((runSize > 0U) && (addScratch(data, runSize) == nullptr))
+        {
+            return 0U;
+        }
+
+        overheadCount = static_cast<uint8_t>(overheadCount + runSize);
+        data += (runSize + (foundNull ? 1U : 0U));
+        remaining -= (runSize + (foundNull ? 1U : 0U));
+
+        // If we have reached a DELIMITER, or filled the block, terminate this block and restart with a new one.
+        if (foundNull || (overheadCount == MAX_BLOCK_SIZE))
+        {
+            *overheadByte = static_cast<uint8_t>(overheadCount ^ DELIMITER);
+            overheadCount = 0x01;
+            overheadByte = addScratch(&DELIMITER, 1U);
+
+            if (overheadByte == nullptr)
+            {
+                return 0U;
+            }
+        }
+    }
+
+    // Then add the CRC, a byte at a time as it is generated into scratch anyway.
+    uint8_t crcBytes[CRC_SIZE];
+    cobs::storeChecksum(ChecksumPolicy::end(crc), crcBytes);
+
+    for (const uint8_t byte : crcBytes)
+    {
+        if ((byte != DELIMITER) && (addScratch(&byte, 1U) == nullptr))
+        {
+            return 0U;
+        }
+
+        overheadCount = static_cast<uint8_t>(overheadCount + ((byte != DELIMITER) ? 1U : 0U));
+
+        if ((byte == DELIMITER) || (overheadCount == MAX_BLOCK_SIZE))
+        {
+            *overheadByte = static_cast<uint8_t>(overheadCount ^ DELIMITER);
+            overheadCount = 0x01;
+            overheadByte = addScratch(&DELIMITER, 1U);
+
+            if (overheadByte == nullptr)
+            {
+                return 0U;
+            }
+        }
+    }
+
+    *overheadByte = static_cast<uint8_t>(overheadCount ^ DELIMITER); // Update the overhead count for the final block.
+
+    if (addScratch(&DELIMITER, 1U) == nullptr) // Finally, append the DELIMITER signalling end of frame.
+    {
+        return 0U;
+    }
+
+    segmentCount = segmentsUsed;
+
+    return encodedSize;
+}
+
+
+/*
+ * Encodes a payload in place, for buffers laid out as ENCODE_HEADROOM bytes of headroom followed by the payload.
+ *
+ * The frame is written from the start of the buffer. Each block only grows the frame by its overhead byte, so with enough headroom the
+ * encoded output never overtakes the payload being read and each delimiter free run is simply moved down into its final position.
+ *
+ * @param   buffer: Buffer holding the payload at buffer[ENCODE_HEADROOM], overwritten with the encoded frame.
+ * @param   bufferSize: Total number of bytes available in buffer, must be at least maxEncodedSize(payloadSize) and hold the payload.
+ * @param   payloadSize: Total number of bytes in the payload, at most MAX_FRAME_SIZE.
+ *
+ * @return  Total amount of encoded bytes, zero if the payload is too large or the buffer is too small.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+uint32_t
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::encodeInPlace(uint8_t* buffer, const uint32_t bufferSize, const uint32_t payloadSize)
+{
+    // The headroom is only guaranteed to cover the overhead bytes of payloads up to MAX_FRAME_SIZE.
+    if ((payloadSize > MAX_FRAME_SIZE) || (bufferSize < (ENCODE_HEADROOM + payloadSize)))
+    {
+        return 0U;
+    }
+
+    return encodeMessage((buffer + ENCODE_HEADROOM), payloadSize, buffer, bufferSize);
+}
+
+
+#ifndef COBS_NO_HEAP
+/*
+ * Encodes many messages back to back into one buffer, ready to be sent with a single write().
+ *
+ * @param   messages: Messages to encode.
+ * @param   messageCount: Total number of messages.
+ * @param   output: Location to store the encoded frames. Resized to fit, so no allocation is made once it has grown to its steady state size.
+ * @param   offsets: Resized to messageCount and filled with the offset of each encoded frame in output.
+ *
+ * @return  Total amount of encoded bytes.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+uint32_t
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::encodeBatch(const COBSSegment* messages, const uint32_t messageCount, std::vector<uint8_t>& output, std::vector<uint32_t>& offsets)
+{
+    uint32_t expectedLen = 0U;
+
+    for (uint32_t i = 0U; i < messageCount; ++i)
+    {
+        expectedLen += maxEncodedSize(messages[i].size);
+    }
+
+    // As with encodeMessage(), resize to the worst case length first and shrink to the actual length afterwards.
+    output.resize(expectedLen);
+    offsets.resize(messageCount);
+
+    const uint32_t actualLen = encodeBatch(messages, messageCount, output.data(), expectedLen, offsets.data());
+
+    output.resize(actualLen);
+
+    return actualLen;
+}
+#endif // COBS_NO_HEAP
+
+
+/*
+ * Encodes many messages back to back into a caller supplied buffer, no heap allocation is made.
+ *
+ * @param   messages: Messages to encode.
+ * @param   messageCount: Total number of messages.
+ * @param   output: Location to store the encoded frames.
+ * @param   outputSize: Total number of bytes available in output, must be at least the sum of maxEncodedSize() of every message.
+ * @param   offsets: Location to store the offset of each encoded frame in output, must hold messageCount entries. May be nullptr.
+ *
+ * @return  Total amount of encoded bytes, zero if the output buffer is too small.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+uint32_t
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::encodeBatch(const COBSSegment* messages, const uint32_t messageCount, uint8_t* output, const uint32_t outputSize, uint32_t* offsets)
+{
+    uint32_t encodedSize = 0U;
+
+    for (uint32_t i = 0U; i < messageCount; ++i)
+    {
+        const uint32_t frameSize = encodeMessage(messages[i].data, messages[i].size, (output + encodedSize), (outputSize - encodedSize));
+
+        if (frameSize == 0U)
+        {
+            return 0U;
+        }
+
+        if (offsets != nullptr)
+        {
+            offsets[i] = encodedSize;
+        }
+
+        encodedSize += frameSize;
+    }
+
+    return encodedSize;
+}
+
+
+#ifndef COBS_NO_HEAP
+/*
+ * Decodes input data using COBS decoding.
+ *
+ * @param   input: Data to decode.
+ *
+ * @return  True if decoded message is validated, else false.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+bool
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::decodeMessage(const std::vector<uint8_t>& input)
+{
+    return decodeMessage(input.data(), static_cast<uint32_t>(input.size()));
+}
+#endif // COBS_NO_HEAP
+
+
+/*
+ * Decodes input data using COBS decoding into the message storage, read it back with getMessage().
+ *
+ * @param   input: Data to decode.
+ * @param   inputSize: Total number of bytes in data.
+ *
+ * @return  True if decoded message is validated, else false.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+bool
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::decodeMessage(const uint8_t* input, const uint32_t inputSize)
+{
+    // In theory, the decoded frame will never be larger than the input buffer. Anything larger than MAX_FRAME_SIZE is rejected with COBSStatus::FRAME_TOO_LARGE, so there is no need to make room for it.
+    const uint32_t outputSize = ((inputSize < (MAX_FRAME_SIZE + CRC_SIZE)) ? inputSize : (MAX_FRAME_SIZE + CRC_SIZE));
+    uint8_t *output = m_message.prepare(outputSize); // See the storage policy for what happens to the current message should the decoding of this input data fail.
+    uint32_t messageSize = 0U;
+
+    if (decodeMessage(input, inputSize, output, outputSize, messageSize) != COBSStatus::OK)
+    {
+        return false;
+    }
+
+    m_message.commit(messageSize); // The message becomes visible only once it has been validated. This ensures m_message only ever contains validated messages.
+
+    return true;
+}
+
+
+/*
+ * Moves the last validated message out of the parser, e.g. to hand it to another thread without copying it.
+ * The parser is left without a message until the next successful decode. With FixedStorage the message is copied out instead,
+ * read getMessageSize() first as the array does not carry the size.
+ *
+ * @return  The message.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+typename BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::MessageType
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::takeMessage(void)
+{
+    return m_message.take();
+}
+
+
+/*
+ * Returns a message obtained from takeMessage() once it is no longer needed, later frames are decoded into it rather than a new allocation.
+ * This is not thread safe, a message consumed on another thread has to be passed back to the thread which owns the parser first.
+ *
+ * @param   message: Message to recycle.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+void
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::recycleMessage(MessageType&& message)
+{
+    m_message.recycle(std::move(message));
+}
+
+
+/*
+ * Decodes input data using COBS decoding into a caller supplied buffer, no heap allocation is made.
+ *
+ * @param   input: Data to decode.
+ * @param   inputSize: Total number of bytes in data.
+ * @param   output: Location to store the decoded message. The CRC bytes are also decoded into this buffer, inputSize bytes is always enough.
+ *                  May be the same as input, see decodeInPlace().
+ * @param   outputSize: Total number of bytes available in output.
+ * @param   messageSize: Total amount of bytes in the decoded message, only updated when the message is validated.
+ *
+ * @return  COBSStatus::OK if decoded message is validated, else the reason it was rejected.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+COBSStatus
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::decodeMessage(const uint8_t* input, const uint32_t inputSize, uint8_t* output, const uint32_t outputSize, uint32_t& messageSize)
+{
+    const uint8_t *encodedMessage = input; // Point at the input data in preparation to iterate through each byte.
+    const uint8_t *encodedMessageEnd = (input + inputSize); // Locate the end of the encoded message so we know when to stop iterating.
+    uint8_t *decodedMessage = output; // Point at the output buffer, this is where the next decoded byte is written.
+    const size_t maxDecodedSize = (MAX_FRAME_SIZE + CRC_SIZE); // Decoding stops as soon as the frame goes past this, so garbage is never decoded or checksummed in full.
+    const uint8_t *decodedMessageEnd = (output + ((outputSize < maxDecodedSize) ? outputSize : maxDecodedSize)); // Whichever limit comes first, so each block needs one check. Which one was hit is only worked out on failure.
+    uint8_t overheadCount = MAX_BLOCK_SIZE; // Initial value unused until the first block has been read.
+    CRCType crc = ChecksumPolicy::begin(); // The CRC is calculated a span at a time as the frame is decoded, while the output is still in cache.
+    const uint8_t *crcPosition = output; // Decoded bytes before this position have been added to the CRC.
+
+    while (encodedMessage < encodedMessageEnd)
+    {
+        // We are starting a new block, read the current byte to determine the size of the block.
+        const uint8_t blockSize = static_cast<uint8_t>(*encodedMessage++ ^ DELIMITER); // Overhead bytes are XORed with the delimiter, so the delimiter reads as a block size of zero.
+
+        if (blockSize == 0U)
+        {
+            // End of frame reached.
+            break;
+        }
+
+        // If the previous block size was partial (!= MAX_BLOCK_SIZE). This implies it was terminated by a DELIMITER, so we must re-insert that DELIMITER now.
+        if (overheadCount != MAX_BLOCK_SIZE)
+        {
+            if (decodedMessage == decodedMessageEnd)
+            {
+                return ((static_cast<size_t>(decodedMessage - output) == maxDecodedSize) ? COBSStatus::FRAME_TOO_LARGE : COBSStatus::OUTPUT_TOO_SMALL);
+            }
+
+            *decodedMessage++ = DELIMITER;
+        }
+
+        overheadCount = blockSize; // Byte is not end of frame, update the next block size.
+
+        // A block holding no data, one per DELIMITER in a dense payload. Branching here means the next block is read without waiting on the size arithmetic below.
+        if (blockSize == 1U)
+        {
+            continue;
+        }
+
+        /*
+         * The rest of the block is data, bounds check the whole block once and copy it across in one go.
+         * A block cut short by the end of the input is copied as far as the input goes.
+         */
+        const size_t remainingInput = static_cast<size_t>(encodedMessageEnd - encodedMessage);
+        const size_t dataSize = (((blockSize - 1U) < remainingInput) ? (blockSize - 1U) : remainingInput);
+
+        if (dataSize > static_cast<size_t>(decodedMessageEnd - decodedMessage))
+        {
+            return (((static_cast<size_t>(decodedMessage - output) + dataSize) > maxDecodedSize) ? COBSStatus::FRAME_TOO_LARGE : COBSStatus::OUTPUT_TOO_SMALL);
+        }
+
+        // Short blocks, which make up payloads dense with DELIMITER bytes, are copied inline as the library call would cost more than the copy.
+        // The byte loop copies forwards and memmove allows overlap, so the output may be the input when decoding in place.
+        if (dataSize < INLINE_RUN_SIZE)
+        {
+            for (size_t i = 0U; i < dataSize; ++i)
+            {
+                decodedMessage[i] = encodedMessage[i];
+            }
+        }
+        else
+        {
+            std::memmove(decodedMessage, encodedMessage, dataSize);
+        }
+
+        decodedMessage += dataSize;
+        encodedMessage += dataSize;
+
+        /*
+         * The last CRC_SIZE decoded bytes may be the received CRC, so the CRC trails that many bytes behind the decoded output.
+         * It is only updated once a whole span has built up, rather than after every block, and the rest is added at the end of the frame.
+         */
+        if (static_cast<size_t>(decodedMessage - crcPosition) > (CRC_SPAN_SIZE + CRC_SIZE))
+        {
+            const uint8_t *crcEnd = (decodedMessage - CRC_SIZE);
+            crc = ChecksumPolicy::update(crc, crcPosition, static_cast<size_t>(crcEnd - crcPosition));
+            crcPosition = crcEnd;
+        }
+    }
+
+    const uint32_t decodedSize = static_cast<uint32_t>(decodedMessage - output);
+
+    // A valid message must contain at least the CRC bytes, do not process further if this is not the case.
+    if (decodedSize < CRC_SIZE)
+    {
+        return COBSStatus::INVALID_FRAME;
+    }
+
+    const uint8_t *receivedCRCPosition = (output + (decodedSize - CRC_SIZE)); // The last bytes in the decoded message are the CRC.
+    const CRCType receivedCRC = cobs::loadChecksum<CRCType>(receivedCRCPosition);
+    const CRCType calculatedCRC = ChecksumPolicy::end(ChecksumPolicy::update(crc, crcPosition, static_cast<size_t>(receivedCRCPosition - crcPosition))); // Add whatever is left before the received CRC.
+
+    if (calculatedCRC != receivedCRC)
+    {
+        return COBSStatus::CRC_MISMATCH;
+    }
+
+    messageSize = (decodedSize - CRC_SIZE); // Exclude the CRC bytes from the message.
+
+    return COBSStatus::OK;
+}
+
+
+/*
+ * Decodes a frame in place, overwriting it with the decoded message so no copy is made out of the receive buffer.
+ *
+ * This works because each block loses its overhead byte when decoded, so the decoded output can never overtake the encoded input being read.
+ *
+ * @param   frame: Frame to decode, overwritten with the decoded message. Its contents are undefined if decoding fails.
+ * @param   frameSize: Total number of bytes in the frame.
+ * @param   message: View of the decoded message at the start of frame, only updated when the message is validated.
+ *
+ * @return  COBSStatus::OK if decoded message is validated, else the reason it was rejected.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+COBSStatus
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::decodeInPlace(uint8_t* frame, const uint32_t frameSize, COBSSegment& message)
+{
+    uint32_t messageSize = 0U;
+    const COBSStatus status = decodeMessage(frame, frameSize, frame, frameSize, messageSize);
+
+    if (status == COBSStatus::OK)
+    {
+        message = {frame, messageSize};
+    }
+
+    return status;
+}
+
+
+#ifndef COBS_NO_HEAP
+/*
+ * Decodes every complete frame in a buffer of back to back frames, e.g. the result of a single read() from a socket.
+ *
+ * All messages are decoded into one shared arena and described by a table of frames, so no memory is allocated once the arena and
+ * frame table have grown to their steady state size. Empty frames (consecutive DELIMITER bytes) are skipped.
+ *
+ * A frame which has not ended within MAX_ENCODED_FRAME_SIZE bytes is reported once as COBSStatus::FRAME_TOO_LARGE without being decoded,
+ * then the rest of it is skipped with cobs::kernels::findDelimiter(), across calls if need be. See getResyncStats().
+ *
+ * @param   input: Data to decode.
+ * @param   inputSize: Total number of bytes in data.
+ * @param   arena: Location to store the decoded messages. It is grown to at least inputSize bytes, but never shrunk, so its size is capacity rather than content.
+ * @param   frames: Cleared, then filled with an entry for every complete frame in the order they were received.
+ *
+ * @return  Index of the first byte not consumed, the start of a trailing partial frame which should be passed in again once the rest has arrived.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+uint32_t
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::decodeBatch(const uint8_t* input, const uint32_t inputSize, std::vector<uint8_t>& arena, std::vector<COBSFrame>& frames)
+{
+    // A decoded message is never larger than its encoded frame, so an arena the size of the input holds every message.
+    if (arena.size() < inputSize)
+    {
+        arena.resize(inputSize);
+    }
+
+    frames.clear();
+
+    uint32_t position = 0U; // Start of the next frame in the input.
+    uint32_t arenaSize = 0U; // Total number of arena bytes holding validated messages.
+
+    while (position < inputSize)
+    {
+        const uint32_t remaining = (inputSize - position);
+        uint32_t searched = 0U; // Bytes from position already known to hold no DELIMITER.
+
+        if (!m_resyncing)
+        {
+            // Locate the end of this frame with the vectorized search. Only the largest valid frame needs to be searched.
+            const uint32_t searchSize = ((remaining < MAX_ENCODED_FRAME_SIZE) ? remaining : MAX_ENCODED_FRAME_SIZE);
+            const uint32_t frameSize = static_cast<uint32_t>(cobs::kernels::findDelimiter((input + position), searchSize, DELIMITER));
+
+            if (frameSize != searchSize)
+            {
+                position += decodeBatchFrame((input + position), (frameSize + 1U), arena, arenaSize, frames);
+                continue;
+            }
+
+            if (searchSize < MAX_ENCODED_FRAME_SIZE)
+            {
+                break; // Partial frame, the rest has not been received yet.
+            }
+
+            // The frame is already too large to be valid, report it and resync on the next DELIMITER.
+            frames.push_back({arenaSize, 0U, COBSStatus::FRAME_TOO_LARGE});
+            m_resyncStats.resyncCount++;
+            m_resyncing = true;
+            m_resyncSize = 0U;
+            searched = searchSize;
+        }
+
+        const uint32_t delimiterPosition = (searched + static_cast<uint32_t>(cobs::kernels::findDelimiter((input + position + searched), (remaining - searched), DELIMITER)));
+        const bool foundDelimiter = (delimiterPosition != remaining);
+        const uint32_t skipSize = (foundDelimiter ? (delimiterPosition + 1U) : remaining);
+
+        m_resyncSize += skipSize;
+        position += skipSize;
+
+        if (foundDelimiter)
+        {
+            m_resyncStats.lastDiscardedBytes = m_resyncSize;
+            m_resyncStats.totalDiscardedBytes += m_resyncSize;
+            m_resyncing = false;
+        }
+    }
+
+    return position;
+}
+#endif // COBS_NO_HEAP
+
+
+/*
+ * Decodes the next byte of a COBS byte stream.
+ *
+ * When this returns true, the validated message can be read via getMessage() and getMessageSize() until the next call.
+ *
+ * @param   byte: Next byte received from the stream.
+ *
+ * @return  True if this byte completed a validated message, else false.
+ */
+template <typename Codec>
+bool
+BasicCOBSStreamDecoder<Codec>::decodeByte(const uint8_t byte)
+{
+    if (byte == Parser::DELIMITER)
+    {
+        /*
+         * End of frame reached. A valid frame must end on a block boundary and contain at least the CRC bytes.
+         * The running CRC already covers exactly the message, so it only has to be compared against the received CRC.
+         */
+        if (m_discarding)
+        {
+            // Resynchronised on this DELIMITER after dropping an oversized frame.
+            m_resyncStats.lastDiscardedBytes = (m_encodedSize + 1U);
+            m_resyncStats.totalDiscardedBytes += m_resyncStats.lastDiscardedBytes;
+        }
+
+        const bool isValid = (!m_discarding && (m_blockSize == 0U) && (m_frameSize >= Parser::CRC_SIZE) &&
+                              (ChecksumPolicy::end(m_crc) == cobs::loadChecksum<typename Parser::CRCType>(&m_buffer[m_frameSize - Parser::CRC_SIZE])));
+
+        if (isValid)
+        {
+            m_messageSize = (m_frameSize - Parser::CRC_SIZE); // Exclude the CRC bytes from the message.
+        }
+
+        reset(); // Prepare for the next frame, this does not touch the decoded data so getMessage() remains valid.
+
+        return isValid;
+    }
+
+    m_encodedSize++;
+
+    if (m_discarding)
+    {
+        return false;
+    }
+
+    uint8_t decodedByte = byte;
+
+    if (m_blockSize > 0U)
+    {
+        m_blockSize--; // Data byte, copied through as is.
+    }
+    else
+    {
+        // We are starting a new block, this byte is the overhead byte which determines the size of the block.
+        const uint8_t blockSize = static_cast<uint8_t>(byte ^ Parser::DELIMITER); // Overhead bytes are XORed with the delimiter.
+        m_blockSize = static_cast<uint8_t>(blockSize - 1U);
+
+        const bool insertNull = (m_overheadCount != Parser::MAX_BLOCK_SIZE); // If the previous block size was partial, it was terminated by a DELIMITER which must be re-inserted now.
+        m_overheadCount = blockSize;
+
+        if (!insertNull)
+        {
+            return false;
+        }
+
+        decodedByte = Parser::DELIMITER;
+    }
+
+    // A frame larger than the buffer can never be valid, this is treated as a syncing issue and the rest of the frame is dropped.
+    if (m_frameSize == m_buffer.size())
+    {
+        m_discarding = true;
+        m_resyncStats.resyncCount++;
+        return false;
+    }
+
+    m_buffer[m_frameSize++] = decodedByte;
+
+    // The last CRC_SIZE bytes of a frame are the received CRC, so a byte is only added to the running CRC once CRC_SIZE more bytes have followed it.
+    if (m_frameSize > Parser::CRC_SIZE)
+    {
+        m_crc = ChecksumPolicy::update(m_crc, &m_buffer[m_frameSize - Parser::CRC_SIZE - 1U], 1U);
+    }
+
+    return false;
+}
+
+
+/*
+ * Discards any partially decoded frame so decoding restarts at the next byte.
+ * The last validated message is left intact.
+ */
+template <typename Codec>
+void
+BasicCOBSStreamDecoder<Codec>::reset(void)
+{
+    m_frameSize = 0U;
+    m_encodedSize = 0U;
+    m_blockSize = 0U;
+    m_overheadCount = Parser::MAX_BLOCK_SIZE;
+    m_crc = ChecksumPolicy::begin();
+    m_discarding = false;
+}
+
+
+/*
+ * Decodes a chunk of the byte stream, invoking the callback for every validated message.
+ * Once a frame has gone over MAX_FRAME_SIZE the rest of it is skipped with cobs::kernels::findDelimiter() rather than a byte at a time.
+ *
+ * @param   input: Data to decode.
+ * @param   inputSize: Total number of bytes in data.
+ * @param   onMessage: Called as onMessage(const uint8_t* message, uint32_t messageSize) for each validated message.
+ *                     The message is only valid for the duration of the call.
+ *
+ * @return  Total amount of validated messages.
+ */
+template <typename Codec>
+template <typename Callback>
+uint32_t
+BasicCOBSStreamDecoder<Codec>::decode(const uint8_t* input, const uint32_t inputSize, Callback&& onMessage)
+{
+    uint32_t messageCount = 0U;
+
+    for (uint32_t i = 0U; i < inputSize; ++i)
+    {
+        if (m_discarding)
+        {
+            const uint32_t next = (i + static_cast<uint32_t>(cobs::kernels::findDelimiter((input + i), (inputSize - i), Parser::DELIMITER)));
+
+            m_encodedSize += (next - i);
+            i = next;
+
+            if (i == inputSize)
+            {
+                break;
+            }
+        }
+
+        if (decodeByte(input[i]))
+        {
+            onMessage(getMessage(), getMessageSize());
+            messageCount++;
+        }
+    }
+
+    return messageCount;
+}
+
+
+// Private methods.
+
+
+/*
+ * Encodes data into the blocks of a frame, carrying on from the current block.
+ *
+ * The first INLINE_RUN_SIZE bytes of each delimiter free run are copied inline, which keeps payloads dense with DELIMITER bytes as cheap as a plain
+ * byte loop. A run which proves longer than that is handed to the copyUntilDelimiter kernel, which uses SIMD where the CPU supports it.
+ * The CRC is updated once per CRC_SPAN_SIZE bytes of input, just before they are encoded, rather than once per run. Each span is still read twice,
+ * once by the CRC and once by the copy, but the copy reads it from L1 cache rather than memory. A frame no larger than a span, which is every
+ * COBSParser frame, is simply checksummed and then encoded.
+ *
+ * @param   input: Data to encode.
+ * @param   inputSize: Total number of bytes in data.
+ * @param   encodedMessage: Position in the output buffer to write the next byte to, advanced past the bytes written.
+ * @param   overheadByte: Position of the current blocks overhead byte, moved when a block is terminated.
+ * @param   overheadCount: Overhead count of the current block.
+ * @param   crc: CRC state to update with the data, nullptr if the data is not part of the CRC.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+void
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::encodeBlocks(const uint8_t* input, uint32_t inputSize, uint8_t*& encodedMessage, uint8_t*& overheadByte, uint8_t& overheadCount, CRCType* crc)
+{
+    // The state is worked on in locals and written back at the end. Every byte stored to the output could alias the referenced state,
+    // which would force it to be reloaded after each store.
+    uint8_t *output = encodedMessage;
+    uint8_t *blockOverhead = overheadByte;
+    uint8_t blockCount = overheadCount;
+
+    while (inputSize > 0U)
+    {
+        const uint32_t spanSize = ((inputSize < CRC_SPAN_SIZE) ? inputSize : CRC_SPAN_SIZE);
+        uint32_t spanRemaining = spanSize; // Bytes of the span still to be encoded.
+
+        /*
+         * The CRC covers the input including its DELIMITER bytes, so the whole span is added in one update rather than one per run.
+         * This has to happen before the span is encoded, as encoding in place overwrites the input behind it. It also brings the span into cache for the copy.
+         */
+        if (crc != nullptr)
+        {
+            *crc = ChecksumPolicy::update(*crc, input, spanSize);
+        }
+
+        inputSize -= spanSize;
+
+        while (spanRemaining > 0U)
+        {
+            // A DELIMITER straight away ends the block with an empty run, common enough in dense payloads to skip the run handling below.
+            if (*input == DELIMITER)
+            {
+                *blockOverhead = static_cast<uint8_t>(blockCount ^ DELIMITER);
+                blockCount = 0x01;
+                blockOverhead = output++;
+                input++;
+                spanRemaining--;
+                continue;
+            }
+
+            const uint32_t blockSpace = (MAX_BLOCK_SIZE - blockCount); // Number of bytes which can still be added to this block before it is full.
+            const uint32_t runLimit = ((spanRemaining < blockSpace) ? spanRemaining : blockSpace);
+            const uint32_t inlineLimit = ((runLimit < INLINE_RUN_SIZE) ? runLimit : INLINE_RUN_SIZE);
+            uint32_t runSize = 0U;
+
+            // Copy bytes across until a DELIMITER is found or the run limit is reached, short runs never leave this loop.
+            for (; (runSize < inlineLimit) && (input[runSize] != DELIMITER); ++runSize)
+            {
+                output[runSize] = input[runSize];
+            }
+
+            // The run has proven long, the kernel copies the rest of it far faster than a byte at a time.
+            if ((runSize == INLINE_RUN_SIZE) && (runSize < runLimit))
+            {
+                runSize += static_cast<uint32_t>(cobs::kernels::copyUntilDelimiter((output + runSize), (input + runSize), (runLimit - runSize), DELIMITER));
+            }
+
+            const bool foundNull = (runSize < runLimit); // The copy stopped early, so the next input byte is a DELIMITER.
+
+            output += runSize;
+            blockCount = static_cast<uint8_t>(blockCount + runSize);
+            input += runSize;
+            spanRemaining -= runSize;
+
+            if (foundNull)
+            {
+                input++; // The DELIMITER is not copied, it is replaced by the overhead byte of the block.
+                spanRemaining--;
+            }
+
+            // If we have reached a DELIMITER, or filled the block (a block can only contain 254 bytes), terminate this block and restart with a new one.
+            if (foundNull || (blockCount == MAX_BLOCK_SIZE))
+            {
+                *blockOverhead = static_cast<uint8_t>(blockCount ^ DELIMITER); // Update the overhead byte for this block, XORed with the delimiter so it can never be mistaken for it.
+                blockCount = 0x01; // Reset the overhead count.
+                blockOverhead = output++; // The next overhead byte now moves to where the encoded message is currently sat at, the encoded message is shifted to the next position.
+            }
+        }
+    }
+
+    encodedMessage = output;
+    overheadByte = blockOverhead;
+    overheadCount = blockCount;
+}
+
+
+#ifndef COBS_NO_HEAP
+/*
+ * Decodes one frame of a batch into the arena and adds it to the frame table.
+ *
+ * @param   frame: Frame to decode.
+ * @param   frameSize: Total number of bytes in the frame, including the DELIMITER.
+ * @param   arena: Location to store the decoded message, see decodeBatch().
+ * @param   arenaSize: Total number of arena bytes holding validated messages, advanced past this message if it is validated.
+ * @param   frames: Frame table to add the frame to.
+ *
+ * @return  Total number of bytes consumed, which is frameSize.
+ */
+template <uint32_t MaxFrame, uint8_t Delimiter, typename ChecksumPolicy, typename StoragePolicy>
+uint32_t
+BasicCOBSCodec<MaxFrame, Delimiter, ChecksumPolicy, StoragePolicy>::decodeBatchFrame(const uint8_t* frame, const uint32_t frameSize, std::vector<uint8_t>& arena, uint32_t& arenaSize, std::vector<COBSFrame>& frames)
+{
+    if (frameSize > 1U)
+    {
+        COBSFrame entry = {arenaSize, 0U, COBSStatus::OK};
+
+        entry.status = decodeMessage(frame, frameSize, (arena.data() + arenaSize), static_cast<uint32_t>(arena.size() - arenaSize), entry.size);
+
+        if (entry.status == COBSStatus::OK)
+        {
+            arenaSize += entry.size; // Keep the message, the CRC bytes after it are overwritten by the next message.
+        }
+        else
+        {
+            entry.size = 0U;
+        }
+
+        frames.push_back(entry);
+    }
+
+    return frameSize;
+}
+#endif // COBS_NO_HEAP
@@ -0,0 +1,183 @@
+#pragma once
+
+// Standard Libraries.
+#include <array>
+#include <cstdint>
+#include <utility>
+#ifndef COBS_NO_HEAP
+#include <vector>
+#endif
+
+
+/*
+ * Storage policies for the message decoded by BasicCOBSCodec::decodeMessage(), selected with the StoragePolicy template parameter.
+ *
+ * Every policy provides a Buffer<Capacity> class template, where Capacity is the largest decoded frame (message plus CRC) it will be asked to hold:
+ *      prepare():  Returns room for at least size bytes (never more than Capacity) which the next frame is decoded into.
+ *      commit():   Makes the first size bytes of the prepared room the current message, called once the frame has been validated.
+ *      data():     First byte of the current message.
+ *      size():     Total number of bytes in the current message.
+ *      take():     Moves the current message out as a MessageType, leaving no current message.
+ *      recycle():  Hands a MessageType back once the caller is done with it, so its memory can be reused.
+ *
+ * Defining COBS_NO_HEAP gives an allocation free build: VectorStorage and every std::vector overload of the codec are left out,
+ * and FixedStorage becomes the default.
+ */
+namespace cobs
+{
+#ifndef COBS_NO_HEAP
+    /*
+     * Heap storage made of two persistent buffers. Frames are decoded into the spare buffer, which is swapped with the message buffer
+     * once validated, so the current message is left intact when a decode fails and no allocation is made once both have grown to the
+     * largest frame seen. Taken messages are moved out without a copy, recycled ones are pooled and used to replace them.
+     *
+     * The buffers only grow, so every SHRINK_INTERVAL frames they are compared against the largest frame of that interval (the high water mark).
+     * Any buffer more than SHRINK_FACTOR times larger is released, so one oversized frame does not pin its memory for good.
+     */
+    struct VectorStorage
+    {
+        static constexpr uint32_t MAX_POOL_SIZE = 4U; // Recycled buffers kept for reuse, any more are freed.
+        static constexpr uint32_t SHRINK_INTERVAL = 1024U; // Frames decoded between checks of the high water mark.
+        static constexpr uint32_t SHRINK_FACTOR = 4U; // Buffers larger than this many times the high water mark are released.
+        static constexpr uint32_t MIN_SHRINK_SIZE = 4096U; // Buffers up to this size are always kept, releasing them saves too little to be worth the reallocation.
+
+        template <uint32_t Capacity>
+        class Buffer
+        {
+            public:
+                using MessageType = std::vector<uint8_t>;
+
+                uint8_t*
+                prepare(const uint32_t size)
+                {
+                    if (++m_frameCount == SHRINK_INTERVAL)
+                    {
+                        shrink();
+                    }
+
+                    m_highWaterMark = ((size > m_highWaterMark) ? size : m_highWaterMark);
+
+                    if ((m_pending.capacity() == 0U) && !m_pool.empty())
+                    {
+                        m_pending = std::move(m_pool.back());
+                        m_pool.pop_back();
+                    }
+
+                    // Only ever grown, so the spare buffer is not zero filled again for every frame.
+                    if (m_pending.size() < size)
+                    {
+                        m_pending.resize(size);
+                    }
+
+                    return m_pending.data();
+                }
+
+                void
+                commit(const uint32_t size)
+                {
+                    m_message.swap(m_pending); // The previous message buffer becomes the spare for the next frame.
+                    m_size = size; // The CRC bytes after the message are simply ignored.
+                }
+
+                MessageType
+                take(void)
+                {
+                    m_message.resize(m_size); // Drop anything past the message, shrinking a vector does not reallocate.
+                    m_size = 0U;
+
+                    return std::move(m_message);
+                }
+
+                void
+                recycle(MessageType&& message)
+                {
+                    if (m_pool.size() < MAX_POOL_SIZE)
+                    {
+                        m_pool.reserve(MAX_POOL_SIZE); // Only allocates the first time, so recycling never allocates afterwards.
+                        m_pool.push_back(std::move(message));
+                        m_pool.back().clear();
+                    }
+                }
+
+                const uint8_t* data(void) const { return m_message.data(); }
+                uint32_t size(void) const { return m_size; }
+
+            private:
+                std::vector<uint8_t> m_message; // Holds the last validated message in its first m_size bytes.
+                std::vector<uint8_t> m_pending; // Spare buffer the next frame is decoded into.
+                std::vector<std::vector<uint8_t>> m_pool; // Recycled buffers waiting to be decoded into.
+                uint32_t m_size = 0U; // Total number of bytes in the message, zero if there is none.
+                uint32_t m_highWaterMark = 0U; // Largest frame prepared for during the current interval.
+                uint32_t m_frameCount = 0U; // Frames prepared for during the current interval.
+
+                // Releases any buffer which has grown far beyond the high water mark of the interval just finished.
+                void
+                shrink(void)
+                {
+                    const size_t limit = ((static_cast<size_t>(m_highWaterMark) * SHRINK_FACTOR) > MIN_SHRINK_SIZE) ? (static_cast<size_t>(m_highWaterMark) * SHRINK_FACTOR) : MIN_SHRINK_SIZE;
+
+                    if (m_pending.capacity() > limit)
+                    {
+                        MessageType().swap(m_pending); // The next frame allocates what it needs.
+                    }
+
+                    if (m_message.capacity() > limit)
+                    {
+                        MessageType(m_message.begin(), (m_message.begin() + m_size)).swap(m_message); // Keeps the current message.
+                    }
+
+                    m_highWaterMark = 0U;
+                    m_frameCount = 0U;
+                }
+        };
+    };
+#endif // COBS_NO_HEAP
+
+
+    /*
+     * Inline storage sized from the frame limit, frames are decoded straight into it so no heap allocation is ever made.
+     * There is only room for one frame, so the current message is dropped (size() becomes zero) as soon as the next decode starts.
+     * A taken message is copied out, as an inline buffer cannot be moved.
+     */
+    struct FixedStorage
+    {
+        template <uint32_t Capacity>
+        class Buffer
+        {
+            public:
+                using MessageType = std::array<uint8_t, Capacity>;
+
+                uint8_t*
+                prepare(const uint32_t)
+                {
+                    m_size = 0U; // The frame is about to be decoded over the current message.
+                    return m_message.data();
+                }
+
+                void commit(const uint32_t size) { m_size = size; }
+
+                MessageType
+                take(void)
+                {
+                    m_size = 0U;
+                    return m_message;
+                }
+
+                void recycle(MessageType&&) {}
+
+                const uint8_t* data(void) const { return m_message.data(); }
+                uint32_t size(void) const { return m_size; }
+
+            private:
+                MessageType m_message; // Last validated message, followed by its CRC bytes.
+                uint32_t m_size = 0U; // Total number of bytes in the message, zero if there is none.
+        };
+    };
+
+
+#ifdef COBS_NO_HEAP
+    using DefaultStorage = FixedStorage;
+#else
+    using DefaultStorage = VectorStorage;
+#endif
+}